@@ -43,7 +43,7 @@ DECLARE_TOOL_FACTORY(BariMcToHitTool);
 BariMcToHitTool::BariMcToHitTool(const std::string& type,
                                  const std::string& name,
                                  const IInterface* parent) :
-AlgTool(type, name, parent)
+AlgTool(type, name, parent), m_events(0), m_maxResampled(0)
 {
     // Declare the additional interface
     declareInterface<IMcToHitTool>(this);
@@ -121,6 +121,9 @@ StatusCode BariMcToHitTool::initialize()
         << " waferside " << SiStripList::die_width()
         << " dead gap " <<  SiStripList::guard_ring()
         << endreq;
+    if ( !SiStripList::stripTable() )
+        log << MSG::WARNING << "strip geometry disagrees with GlastDetSvc, "
+            << "taking strip positions from the service" << endreq;
 
     return sc;
 }
@@ -140,6 +143,7 @@ StatusCode BariMcToHitTool::execute()
     log << MSG::DEBUG << "execute " << endreq;
 
     int kk = 0; // to count hits
+    const long resampled = ClusterPropagator::resampled();
     CurrOr CurrentOr; /// no!!
     TkrDigitizer Digit;
     Digit.Clean();
@@ -221,6 +225,13 @@ StatusCode BariMcToHitTool::execute()
 	    Digit.clusterize(&CurrentOr);
         } // end of loop over hits
     }
+    ++m_events;
+    const long eventResampled = ClusterPropagator::resampled() - resampled;
+    if ( eventResampled > m_maxResampled )
+        m_maxResampled = eventResampled;
+    log << MSG::DEBUG << eventResampled
+        << " carriers diffused off the silicon and resampled" << endreq;
+
     // digital section
     const TotOr* const DigiOr = Digit.digitize(CurrentOr, pToTSvc);
 
@@ -255,3 +266,24 @@ StatusCode BariMcToHitTool::execute()
 
     return sc;
 }
+
+
+StatusCode BariMcToHitTool::finalize()
+{
+    // Purpose and Method: reports how often the electrons and holes of the
+    //                     clusters were diffused off the silicon and had to
+    //                     be resampled, see ClusterPropagator
+    // Inputs: None
+    // Outputs: a status code
+    // Dependencies: None
+    // Restrictions and Caveats: the counts are for all instances of the tool
+
+    MsgStream log(msgSvc(), name());
+    log << MSG::INFO << "cluster propagation: "
+        << ClusterPropagator::carriers() << " carriers, "
+        << ClusterPropagator::resampled() << " resampled, "
+        << ClusterPropagator::fallbacks()
+        << " left undiffused; at most " << m_maxResampled
+        << " resampled in one of " << m_events << " events" << endreq;
+    return StatusCode::SUCCESS;
+}
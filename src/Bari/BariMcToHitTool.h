@@ -34,6 +34,8 @@ class BariMcToHitTool : public AlgTool, virtual public IMcToHitTool {
   StatusCode initialize();
   /// Runs the tool
   StatusCode execute();
+  /// Reports the resampling of the cluster propagation
+  StatusCode finalize();
   
 
 private:
@@ -51,6 +53,10 @@ private:
     std::string m_type;
     /// Pointers to the sub algorithms
     TkrDigiAlg* m_BamcToHitAlg;
+    /// number of events digitized
+    long m_events;
+    /// largest number of carriers resampled in one event
+    long m_maxResampled;
  
 };
 
@@ -12,17 +12,15 @@
 //#  23-Aug-02 change to Tower, Layer, View   LSR                  #
 //##################################################################
 
-#include "CLHEP/Random/RandFlat.h"
-#include "CLHEP/Random/RandGauss.h"
 //#include "CLHEP/config/iostream.h"
 #include "CLHEP/Geometry/Vector3D.h"
 #include "CLHEP/Units/SystemOfUnits.h"
 #include "../SiStripList.h"
+#include "../TkrDigiVariates.h"
 
 #include "Cluster.h"
 #include "TMath.h"
 
-int    Cluster::nhitmax      = 15000;
 double Cluster::SiPitch      = SiStripList::si_strip_pitch();;
 
 // class constructor
@@ -30,6 +28,7 @@ double Cluster::SiPitch      = SiStripList::si_strip_pitch();;
 Cluster::Cluster()
 { 
   NumberOfCluster = 0;
+  NumberLeft      = 0;
 }
 
 Cluster::~Cluster()
@@ -39,6 +38,7 @@ Cluster::~Cluster()
 void Cluster::Clean()
 {
   NumberOfCluster = 0;
+  NumberLeft      = 0;
 }
 
 // method to associate to a position the two near strip
@@ -69,31 +69,39 @@ void  Cluster::xtoid(float xpos, int &id1, int &id2)
 
 // Xi e Xf in mm
 
-void Cluster::SetCluster(HepPoint3D Xi, HepPoint3D Xf, double edepos) 
+void Cluster::SetCluster(HepPoint3D XIn, HepPoint3D XOut, double edepos) 
  {
-   t    = 0.; // track length  
-   ierr = 0;
-   rr   = 0.;
-   Qtot = 0;
-
-   HepVector3D segment = Xf-Xi;
-   double      Len     = segment.mag();
-   HepVector3D dir     = segment.unit();
+   HepVector3D segment = XOut-XIn;
+   Xi  = XIn;
+   Len = segment.mag();
+   dir = segment.unit();
 
    // Bari 1
+   // There used to be a cap of 15000 clusters, the size of the cluster
+   // arrays.  With blocks there is none.
    PairNumber       = static_cast<int>((edepos/CLHEP::eV)/3.6); 
    NumberOfCluster  = static_cast<int>((Len/0.04)*5)+1; // 0.04 10 clus verticali
-   if ( NumberOfCluster > nhitmax ) { NumberOfCluster = nhitmax; }
    if ( NumberOfCluster <= 0 ){ NumberOfCluster = 1; }
+   NumberLeft = NumberOfCluster;
    
    qqq = (PairNumber / NumberOfCluster);
-   for( int i = 0; i < NumberOfCluster; i++){	
-     t      = CLHEP::RandFlat::shoot()*Len;
-     XClust = Xi + t*dir;
-     cr     = CLHEP::RandGauss::shoot(0.,1.)*(sqrt(0.1*qqq)); 
-     QClust = qqq + cr;
-     SetSingleClusterCoordinates(XClust, i);
-     SetSingleClusterCharge(QClust, i);       
-   } 
 } 
 
+
+int Cluster::NextBlock()
+{
+   const int n = NumberLeft<blockSize ? NumberLeft : blockSize;
+   NumberLeft -= n;
+
+   const double sigma = sqrt(0.1*qqq);
+   TkrDigiVariates& rand = TkrDigiVariates::global();
+   for( int i = 0; i < n; i++){	
+     t      = rand.flat()*Len;
+     cr     = rand.gauss()*sigma; 
+     QClust = qqq + cr;
+     XCluster[i] = Xi.x() + t*dir.x();
+     ZCluster[i] = Xi.z() + t*dir.z();
+     QCluster[i] = QClust;
+   } 
+   return n;
+}
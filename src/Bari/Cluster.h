@@ -31,11 +31,26 @@ public:
     Cluster();
     ~Cluster();
 
+    /// number of clusters in a block
+    enum { blockSize = 64 };
 
-    
-    HepPoint3D* GetClusCoord() { return XCluster;} 
-    double* GetClusCharge()    { return QCluster;} 
-    int* GetClusID()           { return IDCluster;}
+    /**
+     * Starts the clusters of a track segment.  They are made block by block
+     * by NextBlock(), so a long path takes no more memory than a short one.
+     */
+    void SetCluster(HepPoint3D, HepPoint3D, double);
+    /**
+     * Makes the next block of clusters of the segment: positions (x and z,
+     * in the local frame) and charges, in GetClusX(), GetClusZ() and
+     * GetClusCharge().
+     * @return  number of clusters in the block, 0 after the last one
+     */
+    int NextBlock();
+
+    const double* GetClusX()      const { return XCluster;} 
+    const double* GetClusZ()      const { return ZCluster;} 
+    const double* GetClusCharge() const { return QCluster;} 
+    /// number of clusters of the segment
     int GetNumberOfClusters()  { return NumberOfCluster;}  
     int GetTower()             { return Tower;}
     int GetLayer()             { return Layer;}
@@ -43,76 +58,34 @@ public:
     
     static double SiPitch; 
     inline double GetPitch(){return SiPitch;}
-    void SetCluster(HepPoint3D, HepPoint3D, double);
     void Clean();  
     void xtoid(float, int&, int&);
 
-    double* GetStripCharge()    { return QStrip;} 
-    int* GetStripID()           { return IDStrip;}
-    int GetNumberOfStrip()  { return NumberOfStrip;}  
-
 private:
     
-    inline void SetSingleClusterCoordinates(HepPoint3D XClust, int Number)
-    {XCluster[Number] = XClust;};
-    inline void SetSingleClusterCharge(double QCharge, int Number)
-    {QCluster[Number] = QCharge;};
-    inline void SetSingleClusterID(int ID, int Number)
-    {IDCluster[Number]= ID;};
-    
-    
     int View; // 0 X 1 Y
     int Layer;
     int Tower;
-    static int nhitmax; //15000
-    HepPoint3D XCluster[15000];
-    double QCluster [15000];
-    int IDCluster[15000]; 
-    int NumberOfCluster; // MAX 5000
-    double Frac;
-    double QStrip[5000];
-    int IDStrip[5000]; 
+    /// the current block
+    double XCluster[blockSize];
+    double ZCluster[blockSize];
+    double QCluster[blockSize];
+    int NumberOfCluster;
+    /// clusters of the segment not made yet
+    int NumberLeft;
 
-  int NumberOfStrip; // MAX 5000
-  
-  double Etot;
-  int Id1, Id2;
-  int ID1, ID2, ID11, ID21;
-  int NumFiredStrip;
   int PairNumber;
-  double EClus;
-  double len;
-  double L;
-  double dist;
-  double charge;
 
   double qqq;
 
   double t; // track length  
-  HepVector3D XPos;
-  HepPoint3D XClust;
+  /// the segment
+  HepPoint3D  Xi;
+  HepVector3D dir;
+  double Len;
   double QClust;
-  int ierr;
-   
-  double rr;
-  double Qtot;
-  double xl;
   double  cr;
 
-  inline void clear(){
-    //NG vector dimension is 5000
-    for(int i=0; i< 5000; i++){
-      QStrip[i]= 0.;
-      IDStrip[i] = 0;
-    }
-  };
-    
-  inline void SetSingleStripCharge(double QCharge, int Number)
-  { QStrip[Number] = QCharge;};
-
-  inline void SetStripID(int ID, int Number)
-  { IDStrip[Number] = ID; };
-
 };
 
 #endif
@@ -7,36 +7,82 @@
 //#  23-Aug-02 changed y to x; removed Xstrip, AllCurr -- LSR            #
 //########################################################################
 
-#include "CLHEP/Random/Randomize.h"
 //#include "CLHEP/config/iostream.h"
-#include "CLHEP/Random/RandGauss.h"
-#include "TMath.h"
+#include "CLHEP/Units/PhysicalConstants.h"
 #include "ClusterPropagator.h"
 #include "../SiStripList.h"
+#include "../TkrDigiVariates.h"
 
+#include <algorithm>
+#include <cmath>
 
-// method to associate to a position the two near strip
-void  ClusterPropagator::xtoid(float xpos, int &id1, int &id2)
+
+long ClusterPropagator::s_carriers  = 0;
+long ClusterPropagator::s_resampled = 0;
+long ClusterPropagator::s_fallbacks = 0;
+
+
+bool ClusterPropagator::landingDirection(const double x, const double sigma,
+                                         TkrDigiVariates& rand,
+                                         double& cosPhi, double& sinPhi)
 {
-  // if out of silicon wafer  id1=id2=-1
-  double XX1 = 0., XX2 = 0.;
-  double dist1, dist2;
-  id1 = -1;
-  id2 = -1;
-  unsigned int id = SiStripList::stripId(xpos);
-  if (id != 65535) {  // no id found (see SiliconPlaneGeometry)
-    unsigned int yy = id +1, jj = id -1;
-    XX1 = SiStripList::calculateBin(yy);
-    XX2 = SiStripList::calculateBin(jj);
-    dist1 = fabs(xpos*1000. - XX1*1000.);
-    dist2 = fabs(xpos*1000. - XX2*1000.);
-    //
-    id1 = id;
-    if(dist1 > dist2){id2 = id1 - 1;}
-    else{id2 = id1 + 1;}
+    // Purpose and Method: the carrier lands at x + cos(phi)*sigma.  For each
+    //                     die, the values of cos(phi) landing on its active
+    //                     area make an interval [cLo, cHi], i.e. phi in
+    //                     [acos(cHi), acos(cLo)] or its mirror in ]pi, 2pi[.
+    //                     One flat number picks a point in the union of these
+    //                     ranges, so phi is uniform among the directions
+    //                     landing on the silicon, as if it had been redrawn
+    //                     until it did, with a single draw.
+    // Inputs: position x and diffusion length sigma, random numbers
+    // Outputs: cos and sin of the direction
+    // Dependencies: the plane geometry of SiStripList
+    // Restrictions and Caveats: the ends of the ranges come from the regular
+    //                           layout; stripId() may still disagree with
+    //                           them by rounding
+
+  const int nDies = SiStripList::n_si_dies();
+  const double pitch = SiStripList::die_width() + SiStripList::ladder_gap();
+  const double width = SiStripList::die_width()
+      - 2.0*SiStripList::guard_ring();
+  const double s = std::fabs(sigma);
+  double lo[8], hi[8];     // phi ranges in [0, pi]
+  double total = 0.;
+  int n = 0;
+  for (int die = 0; die < nDies && n < 8; die++) {
+    const double edge = -0.5*SiStripList::panel_width() + die*pitch
+        + SiStripList::guard_ring();
+    const double tLo = std::max(edge - x, -s);
+    const double tHi = std::min(edge + width - x, s);
+    if (s <= 0. || tLo >= tHi) continue;
+    double cLo = tLo/s, cHi = tHi/s;
+    if (sigma < 0.) {
+      cLo = -tHi/s;
+      cHi = -tLo/s;
+    }
+    lo[n] = std::acos(std::min(cHi, 1.));
+    hi[n] = std::acos(std::max(cLo, -1.));
+    total += hi[n] - lo[n];
+    n++;
+  }
+  if (total <= 0.) return false;
+
+  // the first half of [0, 2*total[ maps to sin>0, the second to sin<0
+  double u = rand.flat()*2.*total;
+  const double sign = u < total ? 1. : -1.;
+  if (u >= total) u -= total;
+  int i = 0;
+  while (i < n-1 && u >= hi[i] - lo[i]) {
+    u -= hi[i] - lo[i];
+    i++;
   }
+  const double phi = std::min(lo[i] + u, hi[i]);
+  cosPhi = std::cos(phi);
+  sinPhi = sign*std::sin(phi);
+  return true;
 }
 
+
 //##################################################################
 // propagate each cluster of the track inside the silicon element
 // and evaluate the currents induced into the closest strips 
@@ -45,89 +91,118 @@ void  ClusterPropagator::xtoid(float xpos, int &id1, int &id2)
 //###################################################################
 
 
-void ClusterPropagator::setClusterPropagator(HepPoint3D* XClus, double* QClus,int NClus, 
+void ClusterPropagator::setClusterPropagator(const double* XClus,
+                                             const double* ZClus,
+                                             const double* QClus, int NClus,
 					      idents::VolumeIdentifier volId,
 					      Event::McPositionHit* pHit)
 { 
     // the coordinates of the track are in the *local* coordinate system... 
     // in this system, x always is the measurement direction
-    
-  Qclu      = 0.;
-  XX        = 0.;
-  XX0       = 0.;                    // in mm
-  ZZ0       = -0.2;
-  SigmaEl   = 0.;
-  SigmaHole = 0.;
-  Rphi      =  0;
-  nflag     = -1;
-
-  for (j = 0; j< NClus; j++) {              // loop over cluster
-    XX = XClus[j].x();                      // in the local frame, x is the measured coordinate -- LSR
-    xtoid(XX, Id1, Id2);                   // ID1 main strip fired
-    ID1 = Id1;
-    if(ID1<0) {continue;}                   // goto next cluster
-    XX0   = SiStripList::calculateBin(ID1);
-    Qclu  = QClus[j];                       //pair number
-    XV[0] = XX - XX0;
-    XV[1] = XClus[j].z() - ZZ0;            // mm respect to wafer SR
-    m_current->GetCharge(XV);               // GET charge
-    Icurr     = m_current->GetCh();   
-    SigmaEl   = Icurr[5]  * 10.*(CLHEP::RandGauss::shoot(0.,1.));
-    SigmaHole = Icurr[11] * 10.*(CLHEP::RandGauss::shoot(0.,1.));
-
-  bb:;
-    Rphi       =  (CLHEP::RandFlat::shoot(0.,360.));
-    XVel[0] = XClus[j].x() + (TMath::Cos(Rphi))*SigmaEl;
-    XVel[1] = XClus[j].z() + (TMath::Sin(Rphi))*SigmaEl;
-    
-    xtoid(XVel[0], Id1,Id2);           // Id1 New main strip fired by electron 
-    if(Id1 < 0) goto bb;
-    nflag = int(Id1/384);
-    XX0   = SiStripList::calculateBin(Id1);
-    XVel[0] = XVel[0] - XX0;
-    XVel[1] = XVel[1] - ZZ0;
-    m_current->GetCharge(XVel);        //  GET charge
-    Icurr1     = m_current->GetCh();
-    
-    ID[0] = Id1 - 2;                   // check in the vol
-    ID[1] = Id1 - 1;
-    ID[2] = Id1;
-    ID[3] = Id1 + 1;
-    ID[4] = Id1 + 2;
-
-    for (jj = 0; jj < 5; jj++){
-      Nflag = int(ID[jj]/384);
-      Icurr[0] = Icurr1[jj]*Qclu;
-      if(Nflag == nflag) m_mapCurr->add(volId, ID[jj], Icurr , pHit);
+
+  const TkrPlaneKey key = TkrVolumeIdentifier(volId).getPlaneKey();
+  for (int first = 0; first < NClus; first += blockSize) {
+    const int n = NClus-first < blockSize ? NClus-first : blockSize;
+    propagateBlock(XClus+first, ZClus+first, QClus+first, n, volId, key,
+                   pHit);
+  }
+}
+
+
+void ClusterPropagator::propagateBlock(const double* XClus,
+                                       const double* ZClus,
+                                       const double* QClus, const int NClus,
+                                       const idents::VolumeIdentifier& volId,
+                                       const TkrPlaneKey key,
+                                       Event::McPositionHit* pHit)
+{
+    // Purpose and Method: each stage runs over the whole block before the
+    //                     next one starts, so the loops without lookups or
+    //                     random numbers (trig, window currents) are tight
+    //                     loops over arrays.  The electron and the hole of
+    //                     cluster k are carriers 2k and 2k+1.
+    // Inputs: x, z and charge of up to blockSize clusters, volume identifier
+    //         and its plane key, McPositionHit
+    // Outputs: the currents of the strips are added to m_mapCurr
+    // Dependencies: m_current and m_mapCurr must be set
+    // Restrictions and Caveats: the random numbers are drawn stage by stage,
+    //                           not cluster by cluster
+
+  const double ZZ0 = -0.2;                    // in mm
+  const int perDie = SiStripList::strips_per_die();
+  TkrDigiVariates& rand = TkrDigiVariates::global();
+
+  // main strip of each cluster; clusters off the silicon are dropped
+  int n = 0;
+  for (int j = 0; j < NClus; j++) {
+    const unsigned int id = SiStripList::stripId(XClus[j]);
+    if (id == 65535) continue;              // no id found
+    m_x[n] = XClus[j];                      // in the local frame, x is the measured coordinate -- LSR
+    m_z[n] = ZClus[j];
+    m_q[n] = QClus[j];                      //pair number
+    m_x0[n] = XClus[j] - SiStripList::calculateBin(id);
+    ++n;
+  }
+
+  // diffusion of the electron and the hole
+  for (int k = 0; k < n; k++) {
+    const double* Icurr = m_current->chargeAt(m_x0[k], m_z[k] - ZZ0);
+    m_sigma[2*k]   = Icurr[5]  * 10.*(rand.gauss());
+    m_sigma[2*k+1] = Icurr[11] * 10.*(rand.gauss());
+  }
+
+  // direction of the diffusion, in radians
+  const int nCarriers = 2*n;
+  for (int c = 0; c < nCarriers; c++)
+    m_phi[c] = rand.flat(0., CLHEP::twopi);
+  for (int c = 0; c < nCarriers; c++) {
+    m_cos[c] = std::cos(m_phi[c]);
+    m_sin[c] = std::sin(m_phi[c]);
+  }
+
+  // landing strip of each carrier.  A carrier off the silicon is diffused
+  // again, in a direction drawn among those landing on the silicon, so
+  // there is at most one more draw.  If that still misses (rounding at the
+  // edge of a die), the carrier isn't diffused, and stays at the position
+  // of its cluster, which is on the silicon.
+  s_carriers += nCarriers;
+  for (int c = 0; c < nCarriers; c++) {
+    const int k = c/2;
+    double x = m_x[k] + m_cos[c]*m_sigma[c];
+    unsigned int id = SiStripList::stripId(x);
+    if (id == 65535) {
+      ++s_resampled;
+      if (landingDirection(m_x[k], m_sigma[c], rand, m_cos[c], m_sin[c])) {
+        x  = m_x[k] + m_cos[c]*m_sigma[c];
+        id = SiStripList::stripId(x);
+      }
+      if (id == 65535) {
+        ++s_fallbacks;
+        m_cos[c] = 0.;
+        m_sin[c] = 0.;
+        x  = m_x[k];
+        id = SiStripList::stripId(x);
+      }
     }
+    m_landing[c] = id;
+    m_dx[c] = x - SiStripList::calculateBin(id);
+    m_dz[c] = m_z[k] + m_sin[c]*m_sigma[c] - ZZ0;
+  }
 
-  exit:;
-    Rphi       =  (CLHEP::RandFlat::shoot(0.,360.));
-    XVhole[0] = XClus[j].x() + (TMath::Cos(Rphi))*SigmaHole;
-    XVhole[1] = XClus[j].z() + (TMath::Sin(Rphi))*SigmaHole;
-    
-    xtoid(XVhole[0], Id11,Id22);      // Id11 New main strip fired by hole
-    if(Id11 < 0) goto exit;           // check if ID in the vol
-    
-    nflag = int(Id11/384);
-    XX0   = SiStripList::calculateBin(Id11);
-    XVhole[0] = XVhole[0] - XX0;
-    XVhole[1] = XVhole[1] - ZZ0;
-    m_current->GetCharge(XVhole);     // GET charge
-    Icurr1     = m_current->GetCh();
-
-    ID[0] = Id11 - 2;                // check strip in the vol
-    ID[1] = Id11 - 1;
-    ID[2] = Id11;
-    ID[3] = Id11 + 1;
-    ID[4] = Id11 + 2;
-
-    for (jj = 0; jj < 5; jj++){
-      Nflag = int(ID[jj]/384);
-      Icurr[0] = Icurr1[jj+6]*Qclu;
-      if(Nflag == nflag) m_mapCurr->add(volId, ID[jj], Icurr , pHit);
+  // currents of the strips around the landing strips, on the same die;
+  // the electron currents are the charges 0-4, the hole ones 6-10
+  int nStrips = 0;
+  for (int c = 0; c < nCarriers; c++) {
+    const double* Icurr = m_current->chargeAt(m_dx[c], m_dz[c]) + 6*(c&1);
+    const double Qclu = m_q[c/2];
+    const int die = m_landing[c]/perDie;
+    for (int jj = 0; jj < nWindow; jj++) {
+      const int strip = m_landing[c] - 2 + jj;
+      if (strip/perDie != die) continue;
+      m_strips[nStrips]   = strip;
+      m_currents[nStrips] = Icurr[jj]*Qclu;
+      ++nStrips;
     }
   }
-  // END CLUSTER LOOP
+  m_mapCurr->addWindow(volId, key, nStrips, m_strips, m_currents, pHit);
 }
-
@@ -17,35 +17,67 @@
 
 #include "InitCurrent.h"
 #include "CurrOr.h"
+#include "Cluster.h"
+
+class TkrDigiVariates;
 
 class ClusterPropagator {
  public:
   ClusterPropagator(){}
   ~ClusterPropagator(){}
 
-  void xtoid(float,int&,int&);
-  void setClusterPropagator(HepPoint3D*,double*,int,idents::VolumeIdentifier,
-  		      Event::McPositionHit*); 
+  /// propagates a block of clusters: x, z, charges, number of clusters
+  void setClusterPropagator(const double*,const double*,const double*,int,
+                            idents::VolumeIdentifier,Event::McPositionHit*);
   void setMapCurr(CurrOr* m) { m_mapCurr = m; }
   void setOpenCurr(InitCurrent* m) { m_current = m; }
+
+  /// number of electrons and holes propagated, since the start of the job
+  static long carriers()  { return s_carriers; }
+  /// number of them first diffused off the silicon, and diffused again
+  static long resampled() { return s_resampled; }
+  /// number of them left undiffused, at the position of their cluster
+  static long fallbacks() { return s_fallbacks; }
      
  private:
+  /// clusters propagated in one pass of each loop
+  enum { blockSize = Cluster::blockSize };
+  /// strips around the landing strip of an electron or hole
+  enum { nWindow = 5 };
+
+  /**
+   * draws a direction of diffusion uniformly among those which land on the
+   * silicon, for a carrier at x diffused by sigma
+   * @return  false if there is no such direction
+   */
+  static bool landingDirection(const double, const double, TkrDigiVariates&,
+                               double&, double&);
+
+  /// propagates up to blockSize clusters
+  void propagateBlock(const double*,const double*,const double*,int,
+                      const idents::VolumeIdentifier&,const TkrPlaneKey,
+                      Event::McPositionHit*);
+
   CurrOr* m_mapCurr;
   InitCurrent* m_current;  
-  
-  int ID1, ID[5], Nflag;
-  int Id1, Id2, Id11, Id22;
-  double* Icurr;
-  double* Icurr1;
-  double Ic[5];
-  int j, nt, jj;
-
-  double XV[2], XVel[2], XVhole[2];
-  double Qclu;
-  double XX, XX0, ZZ0;                    // in mm
-  double SigmaEl, SigmaHole;
-  double Rphi;
-  int nflag;
+
+  // per cluster of a block; carriers 2k (electron) and 2k+1 (hole) of
+  // cluster k
+  double m_x[blockSize], m_z[blockSize], m_q[blockSize];
+  /// x relative to the main strip
+  double m_x0[blockSize];
+  double m_sigma[2*blockSize];
+  double m_phi[2*blockSize];
+  double m_cos[2*blockSize], m_sin[2*blockSize];
+  int    m_landing[2*blockSize];
+  double m_dx[2*blockSize], m_dz[2*blockSize];
+  // strips and currents of a block, to add to m_mapCurr
+  int    m_strips[2*blockSize*nWindow];
+  double m_currents[2*blockSize*nWindow];
+
+  static long s_carriers;
+  static long s_resampled;
+  static long s_fallbacks;
 };
 
 #endif
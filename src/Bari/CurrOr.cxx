@@ -11,6 +11,7 @@
 
 #include "CurrOr.h"
 
+#include <algorithm>
 #include <iostream>
 
 
@@ -26,24 +27,106 @@ void CurrOr::print() const {
 }
 
 
+void CurrOr::clear() {
+    m_list.clear();
+    std::fill(m_slots.begin(), m_slots.end(), -1);
+    m_nKeys = 0;
+}
+
+
 // private functions
 
-CurrOr::DigiElemCol::iterator CurrOr::getPos(const idents::VolumeIdentifier
-                                             volId, const int strip) {
-    // Purpose and Method: searches for a given strip in the list of DigiElems.
-    //                     If found, an iterator to that DigiElem is returned,
-    //                     otherwise end().
-    // Inputs: volume identifier and strip id
-    // Outputs: a DigiElemCol::iterator
+namespace {
+    /// Fibonacci hash of plane key and strip, to nBits bits
+    inline int hashSlot(const TkrPlaneKey& key, const int strip,
+                        const int nBits) {
+        const unsigned int packed = static_cast<unsigned int>(key.key()) << 16
+            ^ static_cast<unsigned int>(strip);
+        return ( packed * 2654435769u ) >> ( 32 - nBits );
+    }
+}
+
+
+int CurrOr::getPos(const DigiElem* d, int& slot) {
+    return getPos(d->getKey(), d->getStrip(), d->getVolId(), slot);
+}
+
+
+int CurrOr::getPos(const TkrPlaneKey key, const int strip,
+                   const idents::VolumeIdentifier& volId, int& slot) {
+    // Purpose and Method: searches for a strip in the hash
+    //                     table, from its home slot on, up to a free slot.
+    //                     Two DigiElems are the same strip if strip id and
+    //                     volume identifier agree; the plane key stands for
+    //                     the volume identifier, unless it's invalid.
+    // Inputs: plane key, strip id and volume identifier
+    // Outputs: the position of the strip in m_list or -1, and its slot
     // Dependencies: none
     // Restrictions and Caveats: none
 
-    DigiElemCol::iterator it;
-    for ( it=m_list.begin(); it!=m_list.end(); ++it )
-        if ( it->getStrip() == strip
-             && it->getVolId().getValue() == volId.getValue() )
-            return it;
-    return it;
+    if ( m_slots.empty() )
+        rehash(0);
+    const int mask  = ( 1 << m_nBits ) - 1;
+    for ( slot=hashSlot(key, strip, m_nBits); ; slot=(slot+1)&mask ) {
+        const int pos = m_slots[slot];
+        if ( pos < 0 )
+            return -1;
+        const DigiElem& e = m_list[pos];
+        if ( e.getStrip() == strip && e.getKey() == key
+             && ( key.isValid()
+                  || e.getVolId().getValue() == volId.getValue() ) )
+            return pos;
+    }
+}
+
+
+void CurrOr::insert(const DigiElem* d, int slot) {
+    // Purpose and Method: appends a DigiElem of a new strip to the list, and
+    //                     enters it in the table.  The table is kept at most
+    //                     half full.
+    // Inputs: pointer to a DigiElem, the free slot found by getPos
+    // Outputs: none
+    // Dependencies: none
+    // Restrictions and Caveats: none
+
+    if ( 2*(m_nKeys+1) > static_cast<int>(m_slots.size()) ) {
+        rehash(m_nBits+1);
+        getPos(d, slot);
+    }
+    m_slots[slot] = m_list.size();
+    ++m_nKeys;
+    m_list.push_back(*d);
+}
+
+
+void CurrOr::rehash(const int nBits) {
+    // Purpose and Method: builds the table anew, with 2^nBits slots, from the
+    //                     first DigiElem of each strip in m_list
+    // Inputs: number of bits
+    // Outputs: none
+    // Dependencies: none
+    // Restrictions and Caveats: none
+
+    m_nBits = std::max(nBits, 6);
+    m_slots.assign(1 << m_nBits, -1);
+    const int mask = ( 1 << m_nBits ) - 1;
+    const int size = m_list.size();
+    for ( int pos=0; pos<size; ++pos ) {
+        const DigiElem& e = m_list[pos];
+        int slot = hashSlot(e.getKey(), e.getStrip(), m_nBits);
+        bool first = true;
+        for ( ; m_slots[slot]>=0; slot=(slot+1)&mask ) {
+            const DigiElem& f = m_list[m_slots[slot]];
+            if ( f.getStrip() == e.getStrip() && f.getKey() == e.getKey()
+                 && ( e.getKey().isValid()
+                      || f.getVolId().getValue() == e.getVolId().getValue() ) ) {
+                first = false;   // a repeat from addnew()
+                break;
+            }
+        }
+        if ( first )
+            m_slots[slot] = pos;
+    }
 }
 
 
@@ -54,27 +137,32 @@ void CurrOr::add(const DigiElem* d) {
     // Outputs: none
     // Dependencies: none
     // Restrictions and Caveats: none
-    DigiElemCol::iterator it = getPos(d->getVolId(), d->getStrip());
-    if ( it == m_list.end() ) {           // new plane to add
-    	m_list.push_back(*d);
-    } else { // add to existing plane
-      it->add(d->getCurrent());
-      it->add(d->getHits());
+    int slot;
+    const int pos = getPos(d, slot);
+    if ( pos < 0 ) {           // new strip to add
+        insert(d, slot);
+    } else { // add to existing strip
+      m_list[pos].add(d->getCurrent());
+      m_list[pos].add(d->getHits());
     }
 }
 void CurrOr::addnew(const DigiElem* d) {
     // Purpose and Method: adds a DigiElem to the list.  If it already exists,
-    //                     just add the current and McPositionHits.
+    //                     add the current and McPositionHits to the existing
+    //                     one, and append it anyway.
     // Inputs: pointer to a DigiElem
     // Outputs: none
     // Dependencies: none
     // Restrictions and Caveats: none
-      DigiElemCol::iterator it = getPos(d->getVolId(), d->getStrip());
-      if ( it != m_list.end() ){
-        it->add(d->getCurrent());
-	it->add(d->getHits());
-      } 
-      m_list.push_back(*d); //add in every case  **
+      int slot;
+      const int pos = getPos(d, slot);
+      if ( pos >= 0 ){
+        m_list[pos].add(d->getCurrent());
+	m_list[pos].add(d->getHits());
+        m_list.push_back(*d); //add in every case  **
+      }
+      else
+        insert(d, slot);
 }
 
 
@@ -104,3 +192,42 @@ void CurrOr::add(const DigiElemCol& l) {
   for ( DigiElemCol::const_iterator it=l.begin(); it != l.end(); ++it )
     addnew(&*it);
 }
+
+
+void CurrOr::merge(const CurrOr& c) {
+    // Purpose and Method: adds the DigiElems of another CurrOr with
+    //                     add(DigiElem), so a strip in both lists gets the
+    //                     current and McPositionHits added.  Unlike
+    //                     add(DigiElemCol), nothing is appended twice.
+    // Inputs: a CurrOr
+    // Outputs: none
+    // Dependencies: none
+    // Restrictions and Caveats: none
+  const DigiElemCol& l = c.getList();
+  for ( DigiElemCol::const_iterator it=l.begin(); it != l.end(); ++it )
+    add(&*it);
+}
+
+
+void CurrOr::addWindow(const idents::VolumeIdentifier& volId,
+                       const TkrPlaneKey key, const int n, const int* strips,
+                       const double* I, Event::McPositionHit* pHit) {
+    // Purpose and Method: adds each strip as add(DigiElem) would, but builds
+    //                     a DigiElem only for the strips not in the list yet
+    // Inputs: volume identifier and its plane key, strip ids and currents,
+    //         pointer to a McPositionHit
+    // Outputs: none
+    // Dependencies: none
+    // Restrictions and Caveats: key must be the plane key of volId
+  for ( int i=0; i<n; ++i ) {
+    int slot;
+    const int pos = getPos(key, strips[i], volId, slot);
+    if ( pos < 0 ) {
+      const DigiElem temp(volId, strips[i], &I[i], pHit);
+      insert(&temp, slot);
+    } else {
+      m_list[pos].add(&I[i]);
+      m_list[pos].add(pHit);
+    }
+  }
+}
@@ -21,14 +21,15 @@ class CurrOr {
 
  public:
 
-    CurrOr(){ii=-1;}
+    CurrOr() : m_nKeys(0), m_nBits(0) {ii=-1;}
     ~CurrOr(){}
 
-    typedef std::vector<DigiElem> DigiElemCol;
+    typedef std::vector<DigiElem, TkrDigiArena::Allocator<DigiElem> >
+        DigiElemCol;
 
     const DigiElemCol& getList() const { return m_list; }
     unsigned int size()          const { return m_list.size(); }
-    void clear() { m_list.clear(); }
+    void clear();
 
     /// adds a DigiElem
     void add(const DigiElem*);
@@ -48,22 +49,58 @@ class CurrOr {
 
     /// adds a vector of DigiElem
     void add(const DigiElemCol&);
+    /**
+     * adds the currents of a window of strips of one plane, e.g. around a
+     * cluster.  The plane key is passed in, so it isn't decoded per strip.
+     * @param 1  volume identifier
+     * @param 2  its plane key
+     * @param 3  number of strips
+     * @param 4  strip ids
+     * @param 5  currents, one per strip (DigiElem::Nbin is 1)
+     * @param 6  pointer to a McPositionHit
+     */
+    void addWindow(const idents::VolumeIdentifier&, const TkrPlaneKey,
+                   const int, const int*, const double*,
+                   Event::McPositionHit*);
+    /// adds the DigiElems of another CurrOr, merging the strips in common
+    void merge(const CurrOr&);
 
     void print() const;
 
  private:
 
+    typedef std::vector<int, TkrDigiArena::Allocator<int> > SlotCol;
+
     /// list of DigiElems
     DigiElemCol m_list;
 
     /**
-     * getPos searches for a given strip in the list of DigiElems
-     * @param 1  volume identifier
-     * @param 2  strip id
-     * @return   a DigiElemCol::iterator, pointing to the DigiElem representing
-     *           the strip, or m_list.end().
+     * open addressing hash table of the strips, keyed on the plane key and
+     * the strip id, with linear probing.  A slot holds the position in m_list
+     * of the first DigiElem of a strip, or -1 if it's free.
+     */
+    SlotCol m_slots;
+    /// number of strips in m_slots
+    int m_nKeys;
+    /// m_slots has 2^m_nBits slots
+    int m_nBits;
+
+    /**
+     * getPos searches for the strip of a DigiElem in the list of DigiElems
+     * @param 1  DigiElem
+     * @param 2  slot of the strip in the hash table, or the free slot where
+     *           it would go
+     * @return   the position of the DigiElem representing the strip in
+     *           m_list, or -1.
      */
-    DigiElemCol::iterator getPos(const idents::VolumeIdentifier, const int);
+    int getPos(const DigiElem*, int&);
+    /// as getPos(DigiElem), for plane key, strip id and volume identifier
+    int getPos(const TkrPlaneKey, const int, const idents::VolumeIdentifier&,
+               int&);
+    /// adds a new strip, at the free slot found by getPos
+    void insert(const DigiElem*, int);
+    /// resizes the hash table to 2^nBits slots
+    void rehash(const int nBits);
   int ii;
 
 };
@@ -28,6 +28,7 @@ DigiElem::DigiElem(const idents::VolumeIdentifier volId, const int strip,
     // Restrictions and Caveats: the dimension of m_Ic is hard-coded
  
     m_volId = volId;
+    m_key   = m_volId.getPlaneKey();
     m_strip = strip;
     for ( int i=0; i<Nbin; i++ )
     m_Ic[i] = Ic[i];
@@ -39,13 +40,14 @@ DigiElem::DigiElem(const idents::VolumeIdentifier volId, const int strip,
 
 
 void DigiElem::add(Event::McPositionHit* hit) {
-    // Purpose and Method: adds a McPositionHit, if it is not in the hitList
+    // Purpose and Method: adds a McPositionHit, unless it is the one added
+    //                     last.  Other duplicates are removed by SiStripList,
+    //                     which is where the hits end up.
     // Inputs: pointer to a McPositionHit
     // Outputs: none
     // Dependencies: none
 
-    for ( hitList::const_iterator it=m_hits.begin(); it!=m_hits.end(); ++it )
-      if ( *it == hit )
+    if ( !m_hits.empty() && m_hits.back() == hit )
 	return;
     m_hits.push_back(hit);
 }
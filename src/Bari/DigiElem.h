@@ -12,6 +12,7 @@
 #define DIGIELEM_H
 
 #include "../TkrVolumeIdentifier.h"
+#include "../TkrDigiArena.h"
 
 #include "Event/MonteCarlo/McPositionHit.h"
 
@@ -34,7 +35,10 @@ class DigiElem {
              Event::McPositionHit*);
     ~DigiElem(){}
 
-    typedef std::vector<Event::McPositionHit*> hitList;
+    /// DigiElems live for one event, so their hit lists use the event arena
+    typedef std::vector<Event::McPositionHit*,
+                        TkrDigiArena::Allocator<Event::McPositionHit*> >
+        hitList;
     static const int Nbin = 1; 
     /// adds more current to each element of m_Ic
     void add(const double* I) { for ( int i=0; i<Nbin; ++i ) m_Ic[i] += I[i]; }
@@ -44,10 +48,11 @@ class DigiElem {
     void add(const hitList&);
 
     idents::VolumeIdentifier getVolId() const { return m_volId; }
-    int getTower()             const { return m_volId.getTower().id(); }
-    int getLayer()             const { return m_volId.getLayer(); }
-    int getView()              const { return m_volId.getView(); }
+    int getTower()             const { return m_key.tower(); }
+    int getLayer()             const { return m_key.layer(); }
+    int getView()              const { return m_key.view(); }
     int getStrip()             const { return m_strip; }
+    TkrPlaneKey getKey()       const { return m_key; }
     const hitList& getHits()   const { return m_hits; }
     const double* getCurrent() const { return m_Ic; }
  
@@ -60,6 +65,8 @@ class DigiElem {
      * (e.g. getView()).
      */
     TkrVolumeIdentifier m_volId;
+    /// the plane of m_volId, decoded once
+    TkrPlaneKey m_key;
     /// strip id;
     int m_strip;
     /// array of currents
@@ -19,6 +19,7 @@ const double InitCurrent::Xmin = -0.114;
 const double InitCurrent::Xmax = 0.114;
 const double InitCurrent::Zmin = 0.;
 const double InitCurrent::Zmax = 0.4;
+const double InitCurrent::s_noCharge[InitCurrent::N] = { 0. };
 
 InitCurrent::InitCurrent()
 {
@@ -36,7 +37,7 @@ InitCurrent::InitCurrent()
 
 InitCurrent::~InitCurrent()
 {
-    if (CURR) delete CURR;
+    if (CURR) delete [] CURR;
 }
 
 StatusCode InitCurrent::OpenCurrent(std::string currents)
@@ -75,34 +76,25 @@ StatusCode InitCurrent::OpenCurrent(std::string currents)
 
 void InitCurrent::GetCharge(double* XX)
 {  
-  k1 = 0;
-  k2 = k1 + Nbin;
-  Xpos = XX[0];
-  Zpos = XX[1];
-  DeltaX = (Xmax - Xmin)/Nbin;
-  DeltaZ = (Zmax - Zmin)/Nbin;
+  const double* charge = chargeAt(XX[0], XX[1]);
+  for(j = 0; j < N ; j++){XXcharge[j] = charge[j];}
+}
 
-  for (j = 0; j < Nbin; j++){
-    X[j] = Xmin + DeltaX * (j + 0.5);
-    Z[j] = Zmin + DeltaZ * (j + 0.5);
-  }
- 
-  for(j = 0; j < N ; j++){XXcharge[j] = 0.;}
+const double* InitCurrent::chargeAt(const double x, const double z) const
+{
+  // Purpose and Method: looks up the table bin of a position; no copy, so
+  //                     it can be called for a block of clusters in a loop
+  // Inputs: position (x, z) in mm, relative to the strip and wafer
+  // Outputs: pointer to the N charges of the bin
+  // Dependencies: OpenCurrent() must have been called
+  // Restrictions and Caveats: valid until the next OpenCurrent()
 
+  const double deltaX = (Xmax - Xmin)/Nbin;
+  const double deltaZ = (Zmax - Zmin)/Nbin;
   // check if ix iy are in the right limits
-  int ix = int((Xpos - Xmin)/DeltaX - 0.5); // lower x bin index
-  int iy = int((Zpos - Zmin)/DeltaZ - 0.5); // lower z bin indx
-  if(ix < 0 || ix >= Nbin || iy < 0 || iy >= Nbin) {  // protezione
-    // std::cout<< "WARNING " << ix << " " << iy << std::endl;
-    goto esci; 
-  }
-  P3 = (iy + (ix * Nbin));
-  P2 = ix * Nbin + iy;
-  if(P2>2499){
-    std::cout<<"WARNING P2 greater than  limit!!! "<<P2<<" " <<ix<<" "<<iy<<std::endl;
-    goto esci;
-  }
-  for(j = 0; j < N ; j++){XXcharge[j] = CURR[P2*12+j];}
- esci:;
+  const int ix = int((x - Xmin)/deltaX - 0.5); // lower x bin index
+  const int iy = int((z - Zmin)/deltaZ - 0.5); // lower z bin indx
+  if(ix < 0 || ix >= Nbin || iy < 0 || iy >= Nbin) return s_noCharge;
+  return CURR + (ix*Nbin + iy)*N;
 }
 
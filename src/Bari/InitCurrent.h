@@ -22,6 +22,10 @@ public:
   StatusCode OpenCurrent(std::string);    
   void GetCharge(double*);
   inline double* GetCh(){return XXcharge;}
+  /// the N charges at a position (x, z), or zeros out of the table
+  const double* chargeAt(const double x, const double z) const;
+  /// number of charges per position
+  static int nCharges() { return N; }
     
     
 private:
@@ -31,6 +35,8 @@ private:
   static const int N    = 12;
 
   double* CURR;
+  /// returned by chargeAt() out of the table
+  static const double s_noCharge[N];
   double XXcharge[N];
   double CurrPar[N];
   double X[Nbin], Z[Nbin]; //nbin
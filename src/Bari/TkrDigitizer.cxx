@@ -9,9 +9,9 @@
 ////////////////////////////////////////////////
 
 #include "TkrDigitizer.h"
+#include "../TkrDigiArena.h"
+#include "../TkrDigiVariates.h"
 #include "TMath.h"
-#include "CLHEP/Random/RandFlat.h"
-#include "CLHEP/Random/RandGauss.h"
 //#include "CLHEP/config/iostream.h"
 #include "CLHEP/Geometry/Vector3D.h"
 #include "CLHEP/Units/SystemOfUnits.h"
@@ -29,20 +29,22 @@ typedef HepGeom::Point3D<double>  HepPoint3D;
 typedef HepGeom::Vector3D<double> HepVector3D;
 
 
+// A TkrDigitizer lives for one event, so its parts come from the event
+// arena.
 TkrDigitizer::TkrDigitizer() {
-    m_clusterPar  = new Cluster();
-    m_clusterProp = new ClusterPropagator();
-    m_clusterCurr = new CurrOr();
-    m_totLayer    = new TotOr();  
+    m_clusterPar  = TkrDigiArena::create<Cluster>();
+    m_clusterProp = TkrDigiArena::create<ClusterPropagator>();
+    m_clusterCurr = TkrDigiArena::create<CurrOr>();
+    m_totLayer    = TkrDigiArena::create<TotOr>();
     m_clusterPar->Clean();
 }
 
 
 TkrDigitizer::~TkrDigitizer() {
-    delete m_clusterPar;
-    delete m_clusterProp;
-    delete m_clusterCurr;
-    delete m_totLayer;
+    TkrDigiArena::destroy(m_clusterPar);
+    TkrDigiArena::destroy(m_clusterProp);
+    TkrDigiArena::destroy(m_clusterCurr);
+    TkrDigiArena::destroy(m_totLayer);
 }
 
 void TkrDigitizer::Clean() {
@@ -63,23 +65,27 @@ void TkrDigitizer::set(double energy, HepPoint3D entry, HepPoint3D exit,
 // SetDigit --> analog section
 
 void TkrDigitizer::setDigit(InitCurrent* OpenCurr) {
+  // m_clusterCurr holds the currents of this hit only, see clusterize()
+  m_clusterCurr->clear();
   m_clusterProp->setMapCurr(m_clusterCurr);
   m_clusterProp->setOpenCurr(OpenCurr);
+  // the clusters are made and propagated block by block
   m_clusterPar->SetCluster(m_entry, m_exit, m_energy);
-  int NumberCluster = m_clusterPar->GetNumberOfClusters();
-  double* ClusCharge = m_clusterPar->GetClusCharge();
-  HepPoint3D* ClusCoord = m_clusterPar->GetClusCoord();
-  m_clusterProp->setClusterPropagator(ClusCoord, ClusCharge, NumberCluster,
-					  m_volId, m_hit);
+  int NumberCluster;
+  while ( ( NumberCluster = m_clusterPar->NextBlock() ) > 0 )
+    m_clusterProp->setClusterPropagator(m_clusterPar->GetClusX(),
+                                        m_clusterPar->GetClusZ(),
+                                        m_clusterPar->GetClusCharge(),
+                                        NumberCluster, m_volId, m_hit);
 }
 
 
 
 // Clusterize --> analog section
+// The currents of the hit are merged into the event's CurrOr, which collects
+// them over all hits.  A strip seen before gets the current added.
 void TkrDigitizer::clusterize(CurrOr* CurrentOr) {
-  const CurrOr::DigiElemCol& l = m_clusterCurr->getList();
-  CurrentOr->clear(); 
-  CurrentOr->add(l);
+  CurrentOr->merge(*m_clusterCurr);
 }
 
 
@@ -94,6 +100,7 @@ TotOr* TkrDigitizer::digitize(const CurrOr& CurrentOr,ITkrToTSvc* pToTSvc) {
     // 
     iit = 0;
     T1Trig = 99999999.;
+    TkrDigiVariates& rand = TkrDigiVariates::global();
     for ( CurrOr::DigiElemCol::const_iterator it=l.begin(); it!=l.end(); ++it ){// loop
       const double* PNum = it->getCurrent();     
       PP          = 0;   
@@ -101,12 +108,12 @@ TotOr* TkrDigitizer::digitize(const CurrOr& CurrentOr,ITkrToTSvc* pToTSvc) {
       DeltaT      = 0;
       Qstr        = 0.;
       PP          = PNum[0];
-      cr          = CLHEP::RandGauss::shoot(0.,1.)*(sqrt(0.1*PP)); // random stat fluctuation
-      er          = CLHEP::RandGauss::shoot(0.,1.)*(1500.);        // random el noise fluctuation
+      cr          = rand.gauss()*(sqrt(0.1*PP)); // random stat fluctuation
+      er          = rand.gauss()*(1500.);        // random el noise fluctuation
       CPNum       = PP + er;
       
       if(CPNum > 0){Qstr = CPNum * 1.67E-4;}                       //fCoulomb
-      Gain = Gain0 + CLHEP::RandGauss::shoot(0.,1.)*RmsGain0;
+      Gain = Gain0 + rand.gauss()*RmsGain0;
       V    =  Qstr * Gain;
       if(V > Vsat) V = Vsat;
       if(V > Vth){
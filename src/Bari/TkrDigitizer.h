@@ -32,7 +32,7 @@ class TkrDigitizer {
 	   Event::McPositionHit*);
   /* set digit paramter */
   void setDigit(InitCurrent*);
-  /* set cluster parameter */
+  /* merges the currents of the current hit into the event's */
   void clusterize(CurrOr*);
   void Clean();
   /* digitization */
@@ -85,7 +85,7 @@ class TkrDigitizer {
   ClusterPropagator* m_clusterProp;
   /* Param of cluster */
   Cluster* m_clusterPar;
-  /* set current signals from each cluster */
+  /* set current signals from each cluster, of the current hit */
   CurrOr* m_clusterCurr;
   /* Or of ToT in a layer */
   TotOr* m_totLayer;
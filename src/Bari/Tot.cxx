@@ -3,8 +3,8 @@
 // Author N.GIGLIETTO
 ///////////////////////////////////////////
 
-#include "CLHEP/Random/RandGauss.h"
 #include "Tot.h"
+#include "../TkrDigiVariates.h"
 
 Tot::Tot(){
 }
@@ -16,7 +16,7 @@ void Tot::Put(double* varray){
   // the input array must be 10000 bins voltage signal in mV
   // Author N.Giglietto
   int ndim = 10000;
-  double treshold = CLHEP::RandGauss::shoot(160.,7.); // one for each strip    <==== microV 
+  double treshold = TkrDigiVariates::global().gauss(160.,7.); // one for each strip    <==== microV 
   //std::cout<<"threshold = "<<treshold<<std::endl;
   // reset all variables
   int lcount = 0;
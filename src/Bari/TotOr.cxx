@@ -14,7 +14,7 @@
 
 
 void TotOr::add(const idents::VolumeIdentifier volId, const int strip,
-                const SiStripList::hitList& hits, const int t1, const int t2,
+                const DigiElem::hitList& hits, const int t1, const int t2,
                 const double energy) {
     // Purpose and Method: adds a strip to m_list.  If there is no SiStripList
     //                     associated with the volume identifier, create a new
@@ -23,14 +23,18 @@ void TotOr::add(const idents::VolumeIdentifier volId, const int strip,
     //         start and stop ToT for this strip, and the deposited energy.
     // Dependencies: none
 
-    SiPlaneMapContainer::SiPlaneMap::iterator it = m_list.find(volId);
+    const int plane = SiPlaneMap::planeIndex(volId);
+    if ( plane < 0 )
+        return;
 
-    if ( it == m_list.end() ) { // new plane to add
-	m_list[volId] = new SiStripList;
-        // refresh the iterator
-	it = m_list.find(volId);
+    SiStripList* list = m_list.plane(plane);
+    if ( !list ) { // new plane to add
+        list = SiStripListPool::get();
+        m_list.insert(plane, volId, list);
     }
 
     // add the strip
-    it->second->addStrip(strip, energy, &hits, t1, t2);
+    if ( !hits.empty() )
+        list->addStrip(strip, energy, &hits.front(),
+                       &hits.front() + hits.size(), t1, t2);
 }
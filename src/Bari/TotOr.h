@@ -15,6 +15,7 @@
 #define TotOr_h 1
 
 #include "../SiPlaneMapContainer.h"
+#include "DigiElem.h"
 
 
 class TotOr {
@@ -38,7 +39,7 @@ class TotOr {
      * @param 6  deposited energy
      */
     void add(const idents::VolumeIdentifier, const int,
-             const SiStripList::hitList&, const int, const int, const double);
+             const DigiElem::hitList&, const int, const int, const double);
 
  private:
 
@@ -17,6 +17,8 @@
  */
 
 #include "TkrDigiAlg.h"
+#include "../TkrDigiArena.h"
+#include "../TkrDigiVariates.h"
 
 #include "GaudiKernel/MsgStream.h"
 #include "GaudiKernel/AlgFactory.h"
@@ -125,6 +127,11 @@ StatusCode TkrDigiAlg::execute() {
     MsgStream log(msgSvc(), name());
     log << MSG::DEBUG << "execute" << endreq;
 
+    // new event: rewind the arena of the transient digitization data, and
+    // drop the random numbers drawn before the engine was seeded for it
+    TkrDigiArena::reset();
+    TkrDigiVariates::global().reset();
+
     // check that G4Generator ran successfully
     // if not, exit gracefully
 
@@ -158,5 +165,11 @@ StatusCode TkrDigiAlg::execute() {
 StatusCode TkrDigiAlg::finalize() {
     MsgStream log(msgSvc(), name());
     log << MSG::INFO << "finalize" << endreq;
+    log << MSG::INFO << "event arena: " << TkrDigiArena::allocations()
+        << " allocations, " << TkrDigiArena::bytes() << " bytes in "
+        << TkrDigiArena::resets() << " resets; peak "
+        << TkrDigiArena::peak() << " bytes per event, "
+        << TkrDigiArena::reserved() << " bytes in "
+        << TkrDigiArena::blocks() << " blocks" << endreq;
     return StatusCode::SUCCESS;
 }
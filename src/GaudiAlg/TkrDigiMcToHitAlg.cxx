@@ -9,6 +9,8 @@
  */
 
 #include "TkrDigiMcToHitAlg.h"
+#include "../TkrDigiArena.h"
+#include "../TkrDigiVariates.h"
 
 #include "GaudiKernel/MsgStream.h"
 #include "GaudiKernel/AlgFactory.h"
@@ -73,6 +75,11 @@ StatusCode TkrDigiMcToHitAlg::execute() {
     MsgStream log(msgSvc(), name());
     log << MSG::DEBUG << "execute" << endreq;
 
+    // first step of the chain: the scratch data and the buffered random
+    // numbers of the previous event are gone
+    TkrDigiArena::reset();
+    TkrDigiVariates::global().reset();
+
     sc = m_tool->execute();
 
     return sc;
@@ -90,7 +90,8 @@ StatusCode GeneralChargeTool::initialize() {
 
 
 StatusCode GeneralChargeTool::execute() {
-    // Purpose and Method:  
+    // Purpose and Method: shares the charge of each strip with its neighbours
+    //                     on the same wafer, up to nFrac-1 strips away
     // Inputs: class variables
     // Outputs: additional hits in the Si
     // TDS Inputs: /Event/tmp/siPlaneMapContainer
@@ -110,73 +111,64 @@ StatusCode GeneralChargeTool::execute() {
         return sc;
     }
 
-    const int nStripsW = 384;
-    const int nStrips = nStripsW*4;
-    std::vector<double> eStrip;
-    std::vector<bool> iStrip;
+    // the wafer geometry
+    const int nStripsW = SiStripList::strips_per_die();
+    const int nStrips  = SiStripList::n_si_strips();
+    if ( static_cast<int>(m_eShared.size()) != nStrips )
+        m_eShared.assign(nStrips, 0.0);
 
     double minE = .01*.113;
 
     SiPlaneMapContainer::SiPlaneMap& siPlaneMap = pObject->getSiPlaneMap();
 
     int istr;
-    Event::McPositionHit* nullHit = 0;
 
     SiPlaneMapContainer::SiPlaneMap::iterator itMap=siPlaneMap.begin();
     for ( ; itMap!=siPlaneMap.end(); ++itMap ) { 
         //idents::VolumeIdentifier id = itMap->first;
         SiStripList* sList = itMap->second;
-        SiStripList::iterator itStrip=sList->begin();
-        eStrip.assign(nStrips, 0.0);
-        iStrip.assign(nStrips, false);
-        //std::cout << "Setting strips: " ;
+        // Only the windows around the strips hit are touched.  The strips
+        // come in order, and so do the windows: the strips of a window
+        // beyond the previous ones are appended to m_touched, which stays
+        // sorted.
+        m_touched.clear();
+        int lastTouched = -1;
+        SiStripList::iterator itStrip;
         for (itStrip=sList->begin(); itStrip!=sList->end(); ++itStrip ) {
-            //int status = itStrip->stripStatus();
             double energy = itStrip->energy();
             int stripNum = itStrip->index();
-            iStrip[stripNum] = true;
-            //std::cout << stripNum << " " ;
             int minStrip = nStripsW*(stripNum/nStripsW);
-            int maxStrip = std::min(minStrip + nStripsW -1, nStripsW*4);
+            int maxStrip = minStrip + nStripsW -1;
             int minStr = std::max(minStrip, stripNum-(nFrac-1));
             int maxStr = std::min(maxStrip, stripNum+(nFrac-1));
+            for (istr=std::max(minStr, lastTouched+1); istr<=maxStr; ++istr)
+                m_touched.push_back(istr);
+            if ( maxStr > lastTouched )
+                lastTouched = maxStr;
             for (istr=minStr; istr<=maxStr; ++istr) {
                 if (istr==stripNum) continue;
                 int offset = abs(stripNum-istr);
                 double fracEnergy = energy*m_chargeFrac[offset];
-                eStrip[istr] += fracEnergy;
+                m_eShared[istr] += fracEnergy;
             } // loop over adjacent strips
         } // loop over strips
-        //std::cout << std::endl;
-        /*
-        // check the list again!
-        std::cout << "check list: " ;
-        for(istr=0; istr<nStrips; ++istr) {
-            if (isStart[istr]) {
-            //if (startList[istr]!=sList->end()) {
-                int idx = startList[istr]->index();
-                std::cout << idx << " "  << istr << " ";
-            }
-        }
-        std::cout << std::endl;
-        */
-        //std::cout << "and again: " ;
-        // here we add energy to existing strips or create new ones
-        for(istr=0; istr<nStrips; ++istr) {
-            double addedE = eStrip[istr];
+
+        // here we add energy to existing strips or create new ones, in one
+        // merge, and clear the touched strips for the next plane
+        m_shareStrips.clear();
+        m_shareEnergies.clear();
+        const int nTouched = m_touched.size();
+        for (int i=0; i<nTouched; ++i) {
+            istr = m_touched[i];
+            double addedE = m_eShared[istr];
+            m_eShared[istr] = 0.0;
             if (addedE<minE) continue;
-            /*
-            if (isStart[istr]) {
-                std::cout << istr << " " << startList[istr]->index() << " ";
-            //if(startList[istr]!=sList->end()) {
-                // add the energy
-                startList[istr]->addEnergy(addedE);
-            } else {
-            */
-                sList->addStrip(istr, addedE, nullHit);
-            //}
+            m_shareStrips.push_back(istr);
+            m_shareEnergies.push_back(addedE);
         }
-        //std::cout << std::endl;
+        if ( !m_shareStrips.empty() )
+            sList->mergeStrips(m_shareStrips.size(), &m_shareStrips[0],
+                               &m_shareEnergies[0]);
     } // loop over stripLists
 
     return sc;
@@ -21,6 +21,7 @@
 #include "GlastSvc/GlastDetSvc/IGlastDetSvc.h"
 
 #include <string>
+#include <vector>
 
 #include "../SiPlaneMapContainer.h"
 
@@ -54,6 +55,13 @@ class GeneralChargeTool : public AlgTool, virtual public IChargeTool {
     ITkrToTSvc*       m_totSvc;
     ///
     double m_chargeFrac[nFrac];
+    /// charge shared into each strip of the plane; zero between planes
+    std::vector<double> m_eShared;
+    /// strips of the windows around the strips hit, in order
+    std::vector<int>    m_touched;
+    /// strips getting charge above threshold, and the charge
+    std::vector<int>    m_shareStrips;
+    std::vector<double> m_shareEnergies;
 
 };
 
@@ -21,13 +21,16 @@
 
 #include "../TkrVolumeIdentifier.h"
 #include "../SiStripList.h"
+#include "../SiStripListPool.h"
 
 // Gaudi specific include files
 #include "GaudiKernel/MsgStream.h"
 #include "GaudiKernel/ToolFactory.h"
 #include "GaudiKernel/SmartDataPtr.h"
 
+#include <algorithm>
 #include <string>
+#include <map>
 
 
 //static const ToolFactory<GeneralHitRemovalTool>    s_factory;
@@ -92,10 +95,89 @@ StatusCode GeneralHitRemovalTool::initialize() {
     }
     m_edSvc = dynamic_cast<IDataProviderSvc*>(iService);
 
+    // the strips of a plane, for the bad strip masks
+    if ( SiStripList::initialize(m_gdSvc).isFailure() ) {
+        log << MSG::ERROR << "Couldn't initialize SiStripList" << endreq;
+        return StatusCode::FAILURE;
+    }
+    m_failedMask.assign((SiPlaneMap::nPlanes+31)/32, 0u);
+    m_badMask.clear();
+    m_badFirst.assign(SiPlaneMap::nPlanes, -1);
+    m_badList.assign(SiPlaneMap::nPlanes, std::vector<int>());
+    int nBadPlanes = 0;
+    for ( int plane=0; plane<SiPlaneMap::nPlanes; ++plane ) {
+        updatePlaneHealth(plane);
+        if ( !m_badList[plane].empty() )
+            ++nBadPlanes;
+    }
+    log << MSG::INFO << "health masks: " << nBadPlanes
+        << " planes with bad strips" << endreq;
+
     return sc;
 }
 
 
+void GeneralHitRemovalTool::updatePlaneHealth(const int plane) {
+    // Purpose and Method: asks the failure mode service whether the plane is
+    //                     failed, and the bad strips service for the list of
+    //                     its bad strips.  If the list isn't the one the
+    //                     bitmap of the plane was built from, the bits are
+    //                     set again from the list.
+    // Inputs: plane number
+    // Outputs: m_failedMask, m_badMask, m_badFirst, m_badList
+    // Dependencies: the failure mode and bad strips services, SiStripList
+    //               must be initialized
+    // Restrictions and Caveats: none
+
+    const int tower   = SiPlaneMap::tower(plane);
+    const int bilayer = SiPlaneMap::layer(plane);
+    const int view    = SiPlaneMap::view(plane);
+
+    if ( m_killFailed ) {
+        const unsigned int bit = 1u << (plane&31);
+        if ( m_failSvc && !m_failSvc->empty()
+             && m_failSvc->isFailed(tower, bilayer, view) )
+            m_failedMask[plane>>5] |= bit;
+        else
+            m_failedMask[plane>>5] &= ~bit;
+    }
+    if ( !m_killBadStrips )
+        return;
+
+    const stripCol* bad = 0;
+    if ( m_badStripsSvc && !m_badStripsSvc->empty() )
+        bad = m_badStripsSvc->getBadStrips(tower, bilayer,
+            view==0 ? idents::GlastAxis::X : idents::GlastAxis::Y);
+    const unsigned int nBad = bad ? bad->size() : 0;
+    std::vector<int>& list = m_badList[plane];
+    bool same = nBad == list.size();
+    for ( unsigned int i=0; same && i<nBad; ++i )
+        same = (*bad)[i].getStripNumber() == list[i];
+    if ( same )
+        return;
+
+    list.resize(nBad);
+    for ( unsigned int i=0; i<nBad; ++i )
+        list[i] = (*bad)[i].getStripNumber();
+    if ( nBad == 0 )
+        return;
+    // the plane keeps its bitmap once it has one
+    const int nStrips = SiStripList::n_si_strips();
+    const int nWords  = (nStrips+31) / 32;
+    if ( m_badFirst[plane] < 0 ) {
+        m_badFirst[plane] = m_badMask.size();
+        m_badMask.resize(m_badMask.size()+nWords, 0u);
+    }
+    unsigned int* mask = &m_badMask[m_badFirst[plane]];
+    std::fill(mask, mask+nWords, 0u);
+    for ( unsigned int i=0; i<nBad; ++i ) {
+        const int strip = list[i];
+        if ( strip>=0 && strip<nStrips )
+            mask[strip>>5] |= 1u << (strip&31);
+    }
+}
+
+
 StatusCode GeneralHitRemovalTool::execute() {
     // Purpose and Method:  truncate hits
     // Inputs: StripLists
@@ -120,15 +202,14 @@ StatusCode GeneralHitRemovalTool::execute() {
 
     SiPlaneMapContainer::SiPlaneMap& siPlaneMap = pObject->getSiPlaneMap();
 
-    // full treatment...
-    m_doFailed = m_doBad = m_doTrunc = true;
-    killBadHitsLoop(siPlaneMap);
-    //doRCBufferLoop(siPlaneMap);
-
-    // next, the cable buffers
+    // failed planes and bad strips; the buffers are done on the merged
+    // digis, by truncateDigis()
+    m_doFailed = m_doBad = true;
+    m_doTrunc = false;
+    int nKilledBadHits = 0;
     bool towersOutOfOrder=false, planesOutOfOrder=false;
-    //doCableBufferLoop(siPlaneMap, 
-    //    towersOutOfOrder, planesOutOfOrder);
+    removeHitsLoop(siPlaneMap, nKilledBadHits,
+        towersOutOfOrder, planesOutOfOrder);
 
     //if(towersOutOfOrder || planesOutOfOrder) {
     //    log << MSG::INFO << "There is a problem with the ordering of the SiStrips... " 
@@ -190,7 +271,7 @@ StatusCode GeneralHitRemovalTool::truncateDigis()
         volId.append(botTop);
 
         Event::McPositionHit* ptr = 0;
-        SiStripList* siList = new SiStripList();
+        SiStripList* siList = SiStripListPool::get();
 
         int i;
         for (i=0;i<digi->getNumHits(); ++i) {
@@ -198,7 +279,8 @@ StatusCode GeneralHitRemovalTool::truncateDigis()
             siList->addStrip(strip, 0.0, ptr);
         }
         
-        siPlaneMap[volId] = siList;
+        siPlaneMap.insert(SiPlaneMap::planeIndex(id.id(), layer, view), volId,
+                          0)->second = siList;
         // save the pointer to the digi for this stripList
         stripDigiMap[siList] = digi;
     }    
@@ -208,12 +290,9 @@ StatusCode GeneralHitRemovalTool::truncateDigis()
     m_doFailed = m_doBad = false;
     m_doTrunc = true;
 
-    int nKilledBadHits = 0, nRemovedRCHits = 0, nRemovedCCHits = 0;
-
-    if(m_doFailed || m_doBad) nKilledBadHits = killBadHitsLoop(siPlaneMap);
-    if(m_doTrunc) nRemovedRCHits = doRCBufferLoop(siPlaneMap);
+    int nKilledBadHits = 0;
     bool towersOutOfOrder = false, planesOutOfOrder = false;
-    if(m_doTrunc) nRemovedCCHits = doCableBufferLoop(siPlaneMap, 
+    const int nRemovedStrips = removeHitsLoop(siPlaneMap, nKilledBadHits,
         towersOutOfOrder, planesOutOfOrder);
 
     if(towersOutOfOrder || planesOutOfOrder) {
@@ -223,7 +302,6 @@ StatusCode GeneralHitRemovalTool::truncateDigis()
     }
 
     // remove digis if necessary, stop when it's all done!
-    int nRemovedStrips = nRemovedRCHits+nRemovedCCHits;
     if(nRemovedStrips>0) {
         int stripCount = 0;
         SiPlaneMapContainer::SiPlaneMap::iterator itMap = siPlaneMap.begin();
@@ -258,174 +336,180 @@ StatusCode GeneralHitRemovalTool::truncateDigis()
     StripDigiMap::iterator mapIter = stripDigiMap.begin();      
     for(;mapIter!=stripDigiMap.end(); ++mapIter) {
         SiStripList* stripList = mapIter->first;
-        stripList->clear();
-        delete stripList;
+        SiStripListPool::release(stripList);
     }
     stripDigiMap.clear();
 
     return sc;
 }
 
-int GeneralHitRemovalTool::killBadHitsLoop(
-    SiPlaneMapContainer::SiPlaneMap& siPlaneMap)
+int GeneralHitRemovalTool::removeHitsLoop(
+    SiPlaneMapContainer::SiPlaneMap& siPlaneMap, int& killed,
+    bool& towersOutOfOrder, bool& planesOutOfOrder)
 {
-
+    // Purpose and Method: one traversal of the planes, doing for each plane
+    //                     the failed plane and the bad strips (if m_doFailed,
+    //                     m_doBad), then the controller (RC) and the cable
+    //                     buffers (if m_doTrunc).  The strips up to the split
+    //                     point go through all of it in one sweep.  The high
+    //                     end controller drops the live strips farthest from
+    //                     it, so the strips beyond the split point are counted
+    //                     in the first sweep, and truncated in a second one.
+    //                     The cable counters go on over the planes of a tower.
+    // Inputs: the SiPlaneMap
+    // Outputs: number of strips removed by the buffers; number of strips
+    //          killed as failed or bad; ordering problems
+    // Dependencies: the health masks, the splits service
+    // Restrictions and Caveats: the planes must come in tower order
+
+    killed = 0;
+    towersOutOfOrder = false;
+    planesOutOfOrder = false;
     int removed = 0;
+
+    // the services are looked up in the health masks, which are brought up
+    // to date for the planes with hits
+    const bool doFailed = m_killFailed && m_doFailed;
+    const bool doBad    = m_killBadStrips && m_doBad;
+    const int cableBufferSize = m_doTrunc
+        ? m_splitsSvc->getCableBufferSize() : 0;
+
+    int cableCount[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    int tower0 = -1;
     SiPlaneMapContainer::SiPlaneMap::iterator itMap=siPlaneMap.begin();
     for ( ; itMap!=siPlaneMap.end(); ++itMap ) {
         SiStripList* sList = itMap->second;
-        const TkrVolumeIdentifier volId = itMap->first;  
-        const idents::TowerId towerId     = volId.getTower();
-        const int tower = towerId.id();
-        const int bilayer  = volId.getLayer();
-        const int view     = volId.getView();
-        const idents::GlastAxis::axis axis = volId.getAxis();
-
-        SiStripList::iterator itStrip; 
-        if(m_killFailed&&m_doFailed) {
-            if ( m_killFailed && m_failSvc && !m_failSvc->empty()) { 
-                if( m_failSvc->isFailed(tower, bilayer, view) ) {
-                    for (itStrip=sList->begin() ;itStrip!=sList->end(); ++itStrip ) {
-                        itStrip->setStripStatus(SiStripList::FAILEDPLANE);
-                        removed++;
-                    }
-                    continue;
+        const TkrPlaneKey key = siPlaneMap.key(itMap);
+        const int tower    = key.tower();
+        const int bilayer  = key.layer();
+        const int view     = key.view();
+        const int plane    = siPlaneMap.indexOf(itMap);
+
+        if ( doFailed || doBad )
+            updatePlaneHealth(plane);
+        const bool failed  = doFailed && isFailedPlane(plane);
+        // bit i of bad is set if strip i is bad
+        const unsigned int* bad = doBad && !failed ? badStrips(plane) : 0;
+
+        // the buffers of the plane
+        int maxLow = 0, maxHigh = 0, breakpoint = 0;
+        int cableLow = 0, cableHigh = 0;
+        bool doRC = false;
+        if ( m_doTrunc ) {
+            if(tower!=tower0) {
+                // clear the counters for a new tower
+                if(tower<tower0) {
+                    towersOutOfOrder = true;
                 }
+                tower0 = tower;
+                int i;
+                for(i=0;i<8;++i) { cableCount[i] = 0;}
             }
-        }
-        // Loop over contained list of strips to remove the bad strips.
-        if(m_killBadStrips&&m_doBad) {
-            for (itStrip=sList->begin();itStrip!=sList->end(); ++itStrip ) {
-                const int stripId = itStrip->index();
-                if ( m_killBadStrips && m_badStripsSvc && !m_badStripsSvc->empty()) {
-                    if ( m_badStripsSvc->isBadStrip(tower, bilayer, axis, stripId) ) {
-                        itStrip->setStripStatus(SiStripList::BADSTRIP);
-                        removed++;
-                    }
-                }
+            // The lost strips are the ones furthest away from the controller
+            if(m_trimDigis) {
+                maxLow  = m_trimCount;
+                maxHigh = m_trimCount;
+            } else {
+                maxLow  = m_splitsSvc->getMaxStrips(tower, bilayer, view, 0);
+                maxHigh = m_splitsSvc->getMaxStrips(tower, bilayer, view, 1);
             }
+            breakpoint = m_splitsSvc->getSplitPoint(tower, bilayer, view);
+            // quick test
+            doRC = sList->size() > std::min(maxLow, maxHigh);
+            cableLow  = m_splitsSvc->getCableIndex(bilayer, view, 0);
+            cableHigh = m_splitsSvc->getCableIndex(bilayer, view, 1);
         }
-    }
-    return removed;
-}
-int GeneralHitRemovalTool::doRCBufferLoop(
-    SiPlaneMapContainer::SiPlaneMap& siPlaneMap)
-{
-    int removed = 0;
-    SiPlaneMapContainer::SiPlaneMap::iterator itMap=siPlaneMap.begin();
-    for ( ; itMap!=siPlaneMap.end(); ++itMap ) {
-        SiStripList* sList = itMap->second;
-        const TkrVolumeIdentifier volId = itMap->first;  
-        const idents::TowerId towerId     = volId.getTower();
-        const int tower = towerId.id();
-        const int bilayer  = volId.getLayer();
-        const int view     = volId.getView();
-        const idents::GlastAxis::axis axis = volId.getAxis();
-        SiStripList::iterator itStrip; 
-        // Truncate the controller buffers
-        // The lost strips are the ones furthest away from the controller 
-        int maxLow, maxHigh;
-        if(m_trimDigis) {
-            maxLow  = m_trimCount;
-            maxHigh = m_trimCount;
-        } else {
-            maxLow  = m_splitsSvc->getMaxStrips(tower, bilayer, view, 0);
-            maxHigh = m_splitsSvc->getMaxStrips(tower, bilayer, view, 1);
-        }
-        int breakpoint = m_splitsSvc->getSplitPoint(tower, bilayer, view);
 
-        // quick test
-        int test    = std::min(maxLow, maxHigh);
-        if (sList->size()>test&&m_doTrunc) {
-            int liveCount  = 0;
+        // first sweep: failed plane, bad strips, and the buffers of the low
+        // end; the live strips of the high end are counted
+        const SiStripList::iterator itEnd = sList->end();
+        SiStripList::iterator itStrip;
+        SiStripList::iterator itHigh = itEnd;
+        int liveLow  = 0;
+        int liveHigh = 0;
+        int strip0   = -1;
+        bool first   = true;
+        for (itStrip=sList->begin(); itStrip!=itEnd; ++itStrip ) {
+            const int stripId = itStrip->index();
+            if ( failed ) {
+                itStrip->setStripStatus(SiStripList::FAILEDPLANE);
+                killed++;
+            }
+            else if ( bad && ( ( bad[stripId>>5] >> (stripId&31) ) & 1u ) ) {
+                itStrip->setStripStatus(SiStripList::BADSTRIP);
+                killed++;
+            }
+            if ( !m_doTrunc )
+                continue;
+            if ( stripId > breakpoint ) {
+                if ( itHigh == itEnd )
+                    itHigh = itStrip;
+                if ( !itStrip->badStrip() )
+                    liveHigh++;
+                continue;
+            }
+            if(stripId< strip0) {
+                planesOutOfOrder = true;
+            }
+            strip0 = stripId;
             // for the low end, we pass maxLow strips, and kill the rest
-            bool first = true;
-            for (itStrip=sList->begin();itStrip!=sList->end(); ++itStrip ) {
-                const int stripId = itStrip->index();
-                if (stripId>breakpoint) break;
-                if (itStrip->badStrip()) continue;
-                liveCount++;
-                if (liveCount>maxLow) {
+            if ( !itStrip->badStrip() ) {
+                liveLow++;
+                if ( doRC && liveLow>maxLow ) {
                     itStrip->setStripStatus(SiStripList::RCBUFFER);
                     removed++;
-                    if(debug) {
-                        if (first) std::cout << "RCBuffer overflow: " ;
+                    if (debug) {
+                        if (first) std::cout << "RCBuffer overflow: ";
                         first = false;
-                        std::cout << itStrip->index() << " " ;
+                        std::cout << stripId << " ";
                     }
                 }
             }
-            // same for the high end, but going backwards
-            liveCount = 0;
-            SiStripList::reverse_iterator itRev;
-            for (itRev=sList->rbegin();itRev!=sList->rend(); ++itRev ) {
-                const int stripId = itRev->index();
-                if (stripId<=breakpoint) break;
-                if(itRev->badStrip()) continue;
-                liveCount++;
-                if (liveCount>maxHigh) {
-                    itRev->setStripStatus(SiStripList::RCBUFFER);
-                    removed++;
-                    if(debug) {
-                        if (first) std::cout << "RCBuffer: " ;
-                        std::cout << itStrip->index() << " " ;
-                    }
+            // a strip dropped by the controller doesn't reach the cable
+            if ( !itStrip->badStrip() )
+                cableCount[cableLow]++;
+            if ( cableCount[cableLow]>cableBufferSize ) {
+                itStrip->setStripStatus(SiStripList::CCBUFFER);
+                removed++;
+                if (debug) {
+                    if (first) std::cout << "CCBuffer overflow: ";
+                    first = false;
+                    std::cout << stripId << " ";
                 }
             }
-            if (!first) std::cout << std::endl;
         }
-    }
-    return removed;
-}
 
-int GeneralHitRemovalTool::doCableBufferLoop(
-    SiPlaneMapContainer::SiPlaneMap& siPlaneMap, 
-    bool& towersOutOfOrder, bool& planesOutOfOrder)
-{
-    towersOutOfOrder = false;
-    planesOutOfOrder = false;
-    int removed = 0;
-    int tower0 = -1;
-    int cableBufferSize = m_splitsSvc->getCableBufferSize();
-    SiPlaneMapContainer::SiPlaneMap::iterator itMap=siPlaneMap.begin();
-    for (itMap=siPlaneMap.begin() ; itMap!=siPlaneMap.end(); ++itMap ) {
-        SiStripList* sList = itMap->second;
-        const TkrVolumeIdentifier volId = itMap->first;  
-        const idents::TowerId towerId   = volId.getTower();
-        const int tower = towerId.id();
-        int cableCount[8];  
-        if(tower!=tower0) {
-            // clear the counters for a new tower
-            if(tower<tower0) {
-                towersOutOfOrder = true;
-            }
-            tower0 = tower;
-            int i;
-            for(i=0;i<8;++i) { cableCount[i] = 0;}
-        }
-        const int bilayer = volId.getLayer();
-        const int view    = volId.getView();
-
-        int breakpoint = m_splitsSvc->getSplitPoint(tower, bilayer, view);
-        SiStripList::iterator itStrip=sList->begin();
-        int strip0 = -1;
-        bool first = true;
-        for ( ;itStrip!=sList->end(); ++itStrip ) {
+        // second sweep, the high end: of the liveHigh live strips, the
+        // controller passes the last maxHigh, and drops the ones before
+        const int drop = doRC ? liveHigh - maxHigh : 0;
+        int liveCount = 0;
+        for (itStrip=itHigh; itStrip!=itEnd; ++itStrip ) {
             const int stripId = itStrip->index();
             if(stripId< strip0) {
                 planesOutOfOrder = true;
             }
             strip0 = stripId;
-            int end = (stripId>breakpoint ? 1 : 0);
-            int index = m_splitsSvc->getCableIndex(bilayer, view, end);
-            if(!itStrip->badStrip()) cableCount[index]++;
-            if(cableCount[index]>cableBufferSize) {
+            if ( !itStrip->badStrip() ) {
+                liveCount++;
+                if ( liveCount<=drop ) {
+                    itStrip->setStripStatus(SiStripList::RCBUFFER);
+                    removed++;
+                    if (debug) {
+                        if (first) std::cout << "RCBuffer overflow: ";
+                        first = false;
+                        std::cout << stripId << " ";
+                    }
+                }
+            }
+            if ( !itStrip->badStrip() )
+                cableCount[cableHigh]++;
+            if ( cableCount[cableHigh]>cableBufferSize ) {
                 itStrip->setStripStatus(SiStripList::CCBUFFER);
                 removed++;
                 if (debug) {
-                    if (first) std::cout << "CCBuffer overflow :";
+                    if (first) std::cout << "CCBuffer overflow: ";
                     first = false;
-                    std::cout << itStrip->index() << " ";
+                    std::cout << stripId << " ";
                 }
             }
         }
@@ -22,6 +22,7 @@
 #include "GaudiKernel/IDataProviderSvc.h"
 
 #include <string>
+#include <vector>
 
 class GeneralHitRemovalTool : public AlgTool, virtual public IHitRemovalTool {
 
@@ -42,13 +43,28 @@ public:
 
 private:
 
-    // does the FailureMode and BadStrips
-    int killBadHitsLoop(SiPlaneMapContainer::SiPlaneMap& siPlaneMap);
-    // does the RC buffers
-    int doRCBufferLoop(SiPlaneMapContainer::SiPlaneMap& siPlaneMap);
-    // does the cable buffer
-    int doCableBufferLoop(SiPlaneMapContainer::SiPlaneMap& siPlaneMap,
-        bool& towersOutofOrder, bool& planesOutofOrder);
+    // does the FailureMode and BadStrips, and the RC and cable buffers, in
+    // one pass over the planes; returns the number of strips truncated
+    int removeHitsLoop(SiPlaneMapContainer::SiPlaneMap& siPlaneMap,
+        int& killed, bool& towersOutofOrder, bool& planesOutofOrder);
+
+    /**
+    * brings the health masks of a plane up to date with the failure mode and
+    * bad strips services, whose contents can be reloaded from the
+    * calibration during the event loop.  The bad strip list of the plane is
+    * compared with the one its bitmap was built from, and the bitmap is
+    * rebuilt from the list if they differ.  removeHitsLoop() calls it for
+    * the planes with hits, then looks them up in the masks.
+    */
+    void updatePlaneHealth(const int plane);
+    /// true if plane is failed
+    bool isFailedPlane(const int plane) const {
+        return ( m_failedMask[plane>>5] >> (plane&31) ) & 1u;
+    }
+    /// bad strip bitmap of a plane, 0 if the plane has no bad strips
+    const unsigned int* badStrips(const int plane) const {
+        return m_badList[plane].empty() ? 0 : &m_badMask[m_badFirst[plane]];
+    }
 
     /// Pointer to the event data service (aka "eventSvc")
     IDataProviderSvc* m_edSvc;
@@ -74,6 +90,17 @@ private:
     bool m_trimDigis;
     int  m_trimCount;
 
+    /// one bit per plane number, set if the plane is failed
+    std::vector<unsigned int> m_failedMask;
+    /// bad strip bitmaps of the planes which had bad strips, one after the
+    /// other
+    std::vector<unsigned int> m_badMask;
+    /// start of the bitmap of each plane in m_badMask, -1 if none
+    std::vector<int>          m_badFirst;
+    /// bad strips of each plane, as the service listed them when the
+    /// bitmap of the plane was built
+    std::vector< std::vector<int> > m_badList;
+
 };
 
 #endif
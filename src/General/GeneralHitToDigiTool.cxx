@@ -32,7 +32,8 @@
 #include "GaudiKernel/SmartDataPtr.h"
 #include "GaudiKernel/DataObject.h"
 
-#include <sstream>
+#include <cstdio>
+#include <string>
 #include <vector>
 
 //static const ToolFactory<GeneralHitToDigiTool>    s_factory;
@@ -327,6 +328,8 @@ StatusCode GeneralHitToDigiTool::execute()
     int nDigi[2] = { 0, 0 };
     int nStrip[2] = { 0, 0 };
     int nStrips = 0;
+    // hits of a strip, reused for all strips
+    SiStripList::hitList hits;
 
     // Create the relational table
     typedef Event::Relation<Event::TkrDigi,Event::McPositionHit> relType;
@@ -371,14 +374,13 @@ StatusCode GeneralHitToDigiTool::execute()
     itMap=siPlaneMap.begin();
     for ( ; itMap!=siPlaneMap.end(); ++itMap ) {
         SiStripList* sList = itMap->second;
-        const TkrVolumeIdentifier volId = itMap->first;  
-        const idents::TowerId tower = volId.getTower();
-        const int theTower = tower.id();
-        //const int tray  = volId.getTray();
-        //const int face  = volId.getBotTop();
-        const int bilayer = volId.getLayer();
-        const int view  = volId.getView();
-        const idents::GlastAxis::axis axis = volId.getAxis();
+        const idents::VolumeIdentifier& volId = itMap->first;
+        const TkrPlaneKey key = siPlaneMap.key(itMap);
+        const int theTower = key.tower();
+        const idents::TowerId tower = key.towerId();
+        const int bilayer = key.layer();
+        const int view  = key.view();
+        const idents::GlastAxis::axis axis = key.axis();
 
         // Failed planes and bad strips now handled in TkrDigiTruncationTool
 
@@ -435,7 +437,7 @@ StatusCode GeneralHitToDigiTool::execute()
                 << endreq;
             }
 
-            const SiStripList::hitList& hits = itStrip->getHits();
+            hits.assign(itStrip->begin(), itStrip->end());
 
             // save the hit here
             Event::McTkrStrip* pStrip =
@@ -444,14 +446,15 @@ StatusCode GeneralHitToDigiTool::execute()
                 itStrip->noise(), hits);
             strips->push_back(pStrip);
 
-            // and add the relation
-            std::ostringstream ost;
-            ost << std::setw(4) << stripId;
+            // and add the relation, with the strip id as info
+            char info[16];
+            std::sprintf(info, "%4d", stripId);
+            const std::string ost(info);
             Event::McTkrStrip::hitList::const_iterator itHit=pStrip->begin();
             for (; itHit!=pStrip->end(); ++itHit ) {
                 Event::McPositionHit* pHit = *itHit;
                 relType *rel = new relType(pDigi, pHit);
-                rel->addInfo(ost.str());
+                rel->addInfo(ost);
                 //addRelation now does the right thing with duplicates
                 // namely, appends the info to the existing info
                 if (!digiHit.addRelation(rel))
@@ -12,12 +12,22 @@
 #include "GeneralNoiseTool.h"
 
 #include "../SiPlaneMapContainer.h"
+#include "../TkrDigiPhilox.h"
+#include "../TkrDigiVariates.h"
+
+#include "Event/TopLevel/EventModel.h"
+#include "Event/TopLevel/Event.h"
 
 // Gaudi specific include files
 #include "GaudiKernel/MsgStream.h"
 #include "GaudiKernel/ToolFactory.h"
 #include "GaudiKernel/SmartDataPtr.h"
 
+#include "facilities/Util.h"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
 #include <string>
 
 
@@ -25,6 +35,20 @@
 //const IToolFactory& GeneralNoiseToolFactory = s_factory;
 DECLARE_TOOL_FACTORY(GeneralNoiseTool);
 
+namespace {
+    /// FNV-1a hash of n bytes, continuing from h
+    unsigned int fnv1a(unsigned int h, const void* data, const std::size_t n)
+    {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for ( std::size_t i=0; i<n; ++i ) {
+            h ^= p[i];
+            h *= 16777619u;
+        }
+        return h;
+    }
+    const unsigned int fnvBasis = 2166136261u;
+}
+
 
 // 1/4 mip, was .03
 //double GeneralNoiseTool::s_noiseThreshold = 0.03875;
@@ -49,6 +73,17 @@ GeneralNoiseTool::GeneralNoiseTool(const std::string& type,
     // but the real fix is overlays
     declareProperty("occupancy",        m_noiseOccupancy = 5.e-6);
     declareProperty("fullThreshold",    m_fullThreshold = false);
+    declareProperty("randomStreams",    m_randomStreams = false);
+    declareProperty("streamSeed",       m_streamSeed = 0);
+    declareProperty("noiseBankSize",    m_bankSize = 0);
+    declareProperty("noiseBankFile",    m_bankFile = "");
+    declareProperty("occupancyFile",    m_occupancyFile = "");
+    declareProperty("printRemovedStrips", m_printRemoved = false);
+
+    m_engine    = 0;
+    m_variates  = 0;
+    m_aliasRate = 0;
+    m_aliasChecksum = 0;
 }
 
 
@@ -84,6 +119,17 @@ StatusCode GeneralNoiseTool::initialize() {
         << " Si layers, ids from " << m_layers.front().name() << " to "
         << m_layers.back().name() << endreq;
 
+    // the plane numbers of the layers, to look them up in the SiPlaneMap
+    m_planes.clear();
+    for ( SiLayerList::const_iterator it=m_layers.begin(); it!=m_layers.end();
+          ++it ) {
+        const int plane = SiPlaneMap::planeIndex(*it);
+        if ( plane < 0 )
+            log << MSG::WARNING << "layer " << it->name()
+                << " is not a tracker plane, no noise added" << endreq;
+        m_planes.push_back(plane);
+    }
+
     IService* iService = 0;
     sc = serviceLocator()->service("EventDataSvc", iService, true );
     if ( sc.isFailure() ) {
@@ -92,12 +138,34 @@ StatusCode GeneralNoiseTool::initialize() {
     }
     m_edSvc = dynamic_cast<IDataProviderSvc*>(iService);
 
+    SiStripList::setPrintRemoved(m_printRemoved);
+
+    if ( m_randomStreams ) {
+        m_engine   = new TkrDigiPhilox(m_streamSeed);
+        m_variates = new TkrDigiVariates(m_engine, 32);
+        log << MSG::INFO << "noise from per-plane random streams, seed "
+            << m_streamSeed << endreq;
+    }
+
+    if ( !m_occupancyFile.empty() ) {
+        sc = loadOccupancies(log);
+        if ( sc.isFailure() )
+            return sc;
+    }
+
+    if ( m_bankSize > 0 )
+        makeNoiseBank(log);
+
     return sc;
 }
 
 
 StatusCode GeneralNoiseTool::execute() {
-    // Purpose and Method:  add noise hits to the SiPlaneMap
+    // Purpose and Method:  add noise hits to the SiPlaneMap: noisy strips
+    //                      over the whole tracker, sampled by
+    //                      sampleNoiseFrame() or taken from a frame of the
+    //                      noise bank, then electronic noise and threshold
+    //                      flags in one pass over each plane
     // Inputs: class variables, especially m_layers, the list of si plane ids.
     // Outputs: additional hits in the Si
     // TDS Inputs: /Event/tmp/siPlaneMapContainer
@@ -120,29 +188,474 @@ StatusCode GeneralNoiseTool::execute() {
 
     SiPlaneMapContainer::SiPlaneMap& siPlaneMap = pObject->getSiPlaneMap();
 
+    // the random streams are keyed by run and event
+    unsigned int       run   = 0;
+    unsigned long long event = 0;
+    if ( m_engine ) {
+        SmartDataPtr<Event::EventHeader> header(m_edSvc,
+                                                EventModel::EventHeader);
+        if ( header ) {
+            run   = header->run();
+            event = header->event();
+        }
+        else
+            log << MSG::WARNING << "no event header, random streams of run 0 "
+                << "event 0" << endreq;
+    }
+
+    TkrDigiVariates& rand = m_variates ? *m_variates
+                                       : TkrDigiVariates::global();
+
+    // noisy strips, from a stream of their own for the whole tracker
+    if ( m_engine ) {
+        m_engine->setStream(run, event, SiPlaneMap::nPlanes,
+                            TkrDigiPhilox::NOISE);
+        m_variates->reset();
+    }
     int noiseCount = 0;
+    const int nFrames = m_bankFirst.empty() ? 0 : m_bankFirst.size() - 1;
+    if ( nFrames > 0 ) {
+        int frame = static_cast<int>(rand.flat()*nFrames);
+        if ( frame >= nFrames )
+            frame = nFrames - 1;
+        const int first = m_bankFirst[frame];
+        const int n     = m_bankFirst[frame+1] - first;
+        if ( n > 0 )
+            noiseCount = mergeNoiseFrame(siPlaneMap, &m_bankStrips[first],
+                                         &m_bankEnergies[first], n);
+    }
+    else {
+        m_frameStrips.clear();
+        m_frameEnergies.clear();
+        sampleNoiseFrame(rand, m_frameStrips, m_frameEnergies);
+        if ( !m_frameStrips.empty() )
+            noiseCount = mergeNoiseFrame(siPlaneMap, &m_frameStrips[0],
+                                         &m_frameEnergies[0],
+                                         m_frameStrips.size());
+    }
 
-    // loop over list of possible layer ids
-    for ( SiLayerList::const_iterator it=m_layers.begin(); it!=m_layers.end();
-          ++it ) {
-        idents::VolumeIdentifier id = *it;
-        if ( siPlaneMap.find(id) == siPlaneMap.end() ) {
-            SiStripList* siPlane = new SiStripList;
-            noiseCount += siPlane->addNoise(m_noiseSigma, m_noiseOccupancy,
-                                            m_noiseThreshold, m_trigThreshold);
-            if ( siPlane->size() > 0 )
-                siPlaneMap[id] = siPlane;
-            else
-                delete siPlane;
+    // electronic noise on the strips hit, and the threshold flags.  The
+    // noisy strips have their noise already, and are above threshold, so
+    // only hit strips can drop out.
+    SiPlaneMap::iterator it;
+    for ( it=siPlaneMap.begin(); it!=siPlaneMap.end(); ++it ) {
+        if ( m_engine ) {
+            m_engine->setStream(run, event, siPlaneMap.indexOf(it),
+                                TkrDigiPhilox::NOISE);
+            m_variates->reset();
         }
-        else
-            noiseCount += siPlaneMap[id]->addNoise(m_noiseSigma,
-                                                   m_noiseOccupancy,
-                                                   m_noiseThreshold,
-                                                   m_trigThreshold);
+        noiseCount -= it->second->addNoiseAndFlag(m_noiseSigma,
+                                                  m_noiseThreshold,
+                                                  m_trigThreshold, &rand);
     }
 
     log << MSG::DEBUG << "added " << noiseCount <<" noise hits" << endreq;
 
     return sc;
 }
+
+
+void GeneralNoiseTool::sampleNoiseFrame(TkrDigiVariates& rand,
+                                        std::vector<unsigned int>& strips,
+                                        std::vector<float>& energies)
+{
+    // Purpose and Method: numbers the strips of all layers of m_layers one
+    //                     after the other, and makes each noisy with its
+    //                     occupancy, independently.
+    //                     With the same occupancy for all strips, walks
+    //                     through them with geometric skips: the number of
+    //                     strips to the next noisy one is floor(E/lambda),
+    //                     with E exponential and lambda = -log(1-occupancy).
+    //                     With per-strip occupancies, draws the hits of a
+    //                     Poisson process of rate sum(lambda_i), each on a
+    //                     strip from the alias table, and drops repeats,
+    //                     flagged in m_inFrame.
+    //                     A strip is then hit at least once with probability
+    //                     1-exp(-lambda_i), its occupancy.
+    // Inputs: random variates
+    // Outputs: the numbers and energies of the noisy strips, appended
+    // Dependencies: m_layers, the alias table, m_inFrame
+    // Restrictions and Caveats: the energy of a noisy strip is distributed as
+    //                           in SiStripList::addNoiseStrips()
+
+    if ( !m_alias.empty() ) {
+        const int    nTotal = m_alias.size();
+        const unsigned int first = strips.size();
+        for ( double t=rand.exponential(); t<m_aliasRate;
+              t+=rand.exponential() ) {
+            int i = static_cast<int>(rand.flat()*nTotal);
+            if ( i >= nTotal )
+                i = nTotal - 1;
+            const unsigned int strip = rand.flat() < m_aliasProb[i]
+                ? i : m_alias[i];
+            if ( m_inFrame[strip] )
+                continue;
+            m_inFrame[strip] = 1;
+            strips.push_back(strip);
+            energies.push_back(m_noiseThreshold*(1.0+rand.exponential()));
+        }
+        for ( unsigned int k=first; k<strips.size(); ++k )
+            m_inFrame[strips[k]] = 0;
+        return;
+    }
+
+    if ( m_noiseOccupancy <= 0.0 )
+        return;
+    const double nTotal = static_cast<double>(m_layers.size())
+        * SiStripList::n_si_strips();
+    // with full occupancy, every strip is noisy
+    const double lambda = m_noiseOccupancy < 1.0
+        ? -std::log(1.0 - m_noiseOccupancy) : HUGE_VAL;
+
+    for ( double pos=std::floor(rand.exponential()/lambda); pos<nTotal;
+          pos+=1.0+std::floor(rand.exponential()/lambda) ) {
+        strips.push_back(static_cast<unsigned int>(pos));
+        energies.push_back(m_noiseThreshold*(1.0+rand.exponential()));
+    }
+}
+
+
+int GeneralNoiseTool::mergeNoiseFrame(SiPlaneMap& siPlaneMap,
+                                      const unsigned int* strips,
+                                      const float* energies,
+                                      const int n) const
+{
+    // Purpose and Method: adds the strips of a noise frame to their planes.
+    //                     A plane is only touched when a noisy strip falls
+    //                     on it.  A noisy strip which is already hit is
+    //                     dropped.
+    // Inputs: the SiPlaneMap, the tracker-wide strip numbers and the energies
+    //         of the frame
+    // Outputs: number of strips added
+    // Dependencies: m_layers, m_planes
+    // Restrictions and Caveats: none
+
+    const int nStrips = SiStripList::n_si_strips();
+    const Event::McPositionHit* noHit = 0;
+
+    int newStrips = 0;
+    for ( int i=0; i<n; ++i ) {
+        const int layer = strips[i] / nStrips;
+        const int strip = strips[i] - layer*nStrips;
+        const int plane = m_planes[layer];
+        if ( plane < 0 )
+            continue;
+        SiStripList* siPlane = siPlaneMap.plane(plane);
+        if ( !siPlane ) {
+            siPlane = SiStripListPool::get();
+            siPlaneMap.insert(plane, m_layers[layer], siPlane);
+        }
+        else if ( siPlane->hasStrip(strip) )
+            continue;
+        siPlane->addStrip(strip, energies[i], noHit);
+        ++newStrips;
+    }
+
+    return newStrips;
+}
+
+
+StatusCode GeneralNoiseTool::loadOccupancies(MsgStream& log)
+{
+    // Purpose and Method: reads the per-strip occupancies, and builds the
+    //                     alias table of the strip rates -log(1-occupancy)
+    //                     by Vose's method: the rates, scaled to a mean of 1,
+    //                     are paired off so that each column of the table
+    //                     holds at most two strips
+    // Inputs: none
+    // Outputs: a status code
+    // Dependencies: m_layers, m_planes, m_noiseOccupancy
+    // Restrictions and Caveats: occupancies must be in [0,1[, and tower,
+    //                           layer and view those of a plane of the LAT;
+    //                           lines for planes not in m_layers are
+    //                           ignored, so a file for the full LAT works
+    //                           for a part of it
+
+    facilities::Util::expandEnvVar(&m_occupancyFile);
+    std::ifstream fin(m_occupancyFile.c_str());
+    if ( !fin ) {
+        log << MSG::ERROR << "occupancy file " << m_occupancyFile
+            << " not found, check jobOptions!" << endreq;
+        return StatusCode::FAILURE;
+    }
+
+    const int nStrips = SiStripList::n_si_strips();
+    const int nTotal  = m_layers.size() * nStrips;
+    std::vector<int> layerOf(SiPlaneMap::nPlanes, -1);
+    for ( unsigned int i=0; i<m_planes.size(); ++i )
+        if ( m_planes[i] >= 0 )
+            layerOf[m_planes[i]] = i;
+
+    const double defaultRate = m_noiseOccupancy < 1.0
+        ? -std::log(1.0 - m_noiseOccupancy) : 0.0;
+    std::vector<double> rate(nTotal, defaultRate);
+    int nLines = 0, nSkipped = 0;
+    std::string line;
+    while ( std::getline(fin, line) ) {
+        const std::string::size_type hash = line.find('#');
+        if ( hash != std::string::npos )
+            line.erase(hash);
+        if ( line.find_first_not_of(" \t\r") == std::string::npos )
+            continue;
+        std::istringstream in(line);
+        int tower, layer, view, first, last;
+        double occupancy;
+        in >> tower >> layer >> view >> first >> last >> occupancy;
+        if ( !in || tower<0 || tower>=SiPlaneMap::nTowers || layer<0
+             || layer>=SiPlaneMap::nLayers || view<0 || view>1
+             || first<0 || last>=nStrips || first>last || occupancy<0.
+             || occupancy>=1. ) {
+            log << MSG::ERROR << "bad line in occupancy file "
+                << m_occupancyFile << ": " << line << endreq;
+            return StatusCode::FAILURE;
+        }
+        // a plane of the LAT that isn't in the detector model
+        const int plane = SiPlaneMap::planeIndex(tower, layer, view);
+        if ( layerOf[plane]<0 ) {
+            ++nSkipped;
+            continue;
+        }
+        const int base = layerOf[plane] * nStrips;
+        for ( int strip=first; strip<=last; ++strip )
+            rate[base+strip] = -std::log(1.0 - occupancy);
+        ++nLines;
+    }
+
+    m_aliasChecksum = fnv1a(fnvBasis, &rate[0], nTotal*sizeof(double));
+    double sum = 0.0, expected = 0.0;
+    for ( int i=0; i<nTotal; ++i ) {
+        sum      += rate[i];
+        expected += 1.0 - std::exp(-rate[i]);
+    }
+    m_aliasProb.assign(nTotal, 1.0);
+    m_alias.resize(nTotal);
+    for ( int i=0; i<nTotal; ++i )
+        m_alias[i] = i;
+    m_aliasRate = sum;
+    m_inFrame.assign(nTotal, 0);
+    if ( sum <= 0.0 ) {
+        log << MSG::WARNING << "all occupancies are 0, no noisy strips"
+            << endreq;
+        return StatusCode::SUCCESS;
+    }
+
+    std::vector<unsigned int> small, large;
+    for ( int i=0; i<nTotal; ++i ) {
+        rate[i] *= nTotal / sum;
+        if ( rate[i] < 1.0 )
+            small.push_back(i);
+        else
+            large.push_back(i);
+    }
+    while ( !small.empty() && !large.empty() ) {
+        const unsigned int s = small.back();
+        const unsigned int l = large.back();
+        small.pop_back();
+        m_aliasProb[s] = rate[s];
+        m_alias[s]     = l;
+        rate[l] -= 1.0 - rate[s];
+        if ( rate[l] < 1.0 ) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // what is left is 1 up to rounding
+
+    if ( nSkipped > 0 )
+        log << MSG::INFO << "skipped " << nSkipped << " lines of occupancies "
+            << "for planes not in the detector model" << endreq;
+    log << MSG::INFO << "read " << nLines << " lines of occupancies from "
+        << m_occupancyFile << ", " << expected
+        << " noisy strips per event on average" << endreq;
+    return StatusCode::SUCCESS;
+}
+
+
+double GeneralNoiseTool::totalRate() const
+{
+    if ( !m_alias.empty() )
+        return m_aliasRate;
+    if ( m_noiseOccupancy <= 0.0 )
+        return 0.0;
+    if ( m_noiseOccupancy >= 1.0 )
+        return HUGE_VAL;
+    return -std::log(1.0 - m_noiseOccupancy)
+        * m_layers.size() * SiStripList::n_si_strips();
+}
+
+
+unsigned int GeneralNoiseTool::modelChecksum() const
+{
+    // Purpose and Method: hashes the volume ids of m_layers, field by field
+    //                     and in their order, and the strip rates: those of
+    //                     the alias table, or the one rate of all strips
+    // Inputs: none
+    // Outputs: the checksum
+    // Dependencies: m_layers, the alias table, m_noiseOccupancy
+    // Restrictions and Caveats: the rates are hashed bit by bit, so a bank
+    //                           may not be taken on another platform
+
+    unsigned int h = fnvBasis;
+    for ( SiLayerList::const_iterator it=m_layers.begin(); it!=m_layers.end();
+          ++it ) {
+        const int n = it->size();
+        h = fnv1a(h, &n, sizeof(n));
+        for ( int i=0; i<n; ++i ) {
+            const unsigned int field = (*it)[i];
+            h = fnv1a(h, &field, sizeof(field));
+        }
+    }
+    if ( !m_alias.empty() )
+        return fnv1a(h, &m_aliasChecksum, sizeof(m_aliasChecksum));
+    return fnv1a(h, &m_noiseOccupancy, sizeof(m_noiseOccupancy));
+}
+
+
+void GeneralNoiseTool::makeNoiseBank(MsgStream& log)
+{
+    // Purpose and Method: reads the noise bank from m_bankFile, or samples
+    //                     m_bankSize frames and writes them to m_bankFile
+    // Inputs: none
+    // Outputs: none
+    // Dependencies: m_bankSize, m_bankFile
+    // Restrictions and Caveats: with random streams, frame i is sampled from
+    //                           the NOISEBANK stream of "event" i, so the bank
+    //                           only depends on the seed
+
+    facilities::Util::expandEnvVar(&m_bankFile);
+    if ( !m_bankFile.empty() && loadNoiseBank(log) )
+        return;
+
+    TkrDigiVariates& rand = m_variates ? *m_variates
+                                       : TkrDigiVariates::global();
+    m_bankStrips.clear();
+    m_bankEnergies.clear();
+    m_bankFirst.assign(1, 0);
+    for ( int frame=0; frame<m_bankSize; ++frame ) {
+        if ( m_engine ) {
+            m_engine->setStream(0, frame, SiPlaneMap::nPlanes,
+                                TkrDigiPhilox::NOISEBANK);
+            m_variates->reset();
+        }
+        sampleNoiseFrame(rand, m_bankStrips, m_bankEnergies);
+        m_bankFirst.push_back(m_bankStrips.size());
+    }
+    log << MSG::INFO << "sampled a noise bank of " << m_bankSize
+        << " frames, " << m_bankStrips.size() << " noisy strips" << endreq;
+
+    if ( !m_bankFile.empty() )
+        saveNoiseBank(log);
+}
+
+
+bool GeneralNoiseTool::loadNoiseBank(MsgStream& log)
+{
+    // Purpose and Method: reads the noise bank.  The file starts with the
+    //                     line
+    //                       TkrDigiNoiseBank nLayers nStrips rate
+    //                                        threshold checksum nFrames
+    //                     where rate is the mean number of noise hits per
+    //                     frame, before repeats (see totalRate()), and
+    //                     checksum identifies the layers and the occupancy
+    //                     of each strip (see modelChecksum())
+    //                     followed by a line per frame: the number of noisy
+    //                     strips, and the number and energy of each.
+    // Inputs: none
+    // Outputs: true if the bank was read
+    // Dependencies: m_bankFile
+    // Restrictions and Caveats: a bank made for other layers, occupancies
+    //                           or threshold isn't used
+
+    std::ifstream fin(m_bankFile.c_str());
+    if ( !fin )
+        return false;
+
+    std::string tag;
+    int nLayers = 0, nStrips = 0, nFrames = 0;
+    double rate = 0, threshold = 0;
+    unsigned int checksum = 0;
+    fin >> tag >> nLayers >> nStrips >> rate >> threshold >> checksum
+        >> nFrames;
+    if ( !fin || tag != "TkrDigiNoiseBank" ) {
+        log << MSG::WARNING << m_bankFile << " is not a noise bank" << endreq;
+        return false;
+    }
+    if ( nLayers != static_cast<int>(m_layers.size())
+         || nStrips != SiStripList::n_si_strips()
+         || std::fabs(rate-totalRate()) > 1e-9*totalRate()
+         || std::fabs(threshold-m_noiseThreshold) > 1e-9*m_noiseThreshold
+         || checksum != modelChecksum() || nFrames <= 0 ) {
+        log << MSG::WARNING << "noise bank " << m_bankFile << " was made for "
+            << nLayers << " layers of " << nStrips << " strips, rate "
+            << rate << ", threshold " << threshold << ", checksum "
+            << checksum << "; sampling a new one" << endreq;
+        return false;
+    }
+
+    m_bankStrips.clear();
+    m_bankEnergies.clear();
+    m_bankFirst.assign(1, 0);
+    const unsigned int nTotal = nLayers * nStrips;
+    for ( int frame=0; frame<nFrames; ++frame ) {
+        int n = 0;
+        fin >> n;
+        for ( int i=0; i<n && fin; ++i ) {
+            unsigned int strip;
+            float energy;
+            fin >> strip >> energy;
+            if ( strip >= nTotal )
+                fin.setstate(std::ios::failbit);
+            m_bankStrips.push_back(strip);
+            m_bankEnergies.push_back(energy);
+        }
+        if ( !fin ) {
+            log << MSG::WARNING << "noise bank " << m_bankFile
+                << " is corrupt in frame " << frame << "; sampling a new one"
+                << endreq;
+            m_bankFirst.clear();
+            return false;
+        }
+        m_bankFirst.push_back(m_bankStrips.size());
+    }
+    log << MSG::INFO << "read a noise bank of " << nFrames << " frames, "
+        << m_bankStrips.size() << " noisy strips, from " << m_bankFile
+        << endreq;
+    return true;
+}
+
+
+void GeneralNoiseTool::saveNoiseBank(MsgStream& log) const
+{
+    std::ofstream fout(m_bankFile.c_str());
+    if ( !fout ) {
+        log << MSG::WARNING << "could not write the noise bank to "
+            << m_bankFile << endreq;
+        return;
+    }
+    fout.precision(17);
+    fout << "TkrDigiNoiseBank " << m_layers.size() << " "
+         << SiStripList::n_si_strips() << " " << totalRate() << " "
+         << m_noiseThreshold << " " << modelChecksum() << " "
+         << m_bankFirst.size()-1 << "\n";
+    fout.precision(9);
+    for ( unsigned int frame=0; frame+1<m_bankFirst.size(); ++frame ) {
+        fout << m_bankFirst[frame+1] - m_bankFirst[frame];
+        for ( int i=m_bankFirst[frame]; i<m_bankFirst[frame+1]; ++i )
+            fout << " " << m_bankStrips[i] << " " << m_bankEnergies[i];
+        fout << "\n";
+    }
+    if ( !fout )
+        log << MSG::WARNING << "could not write the noise bank to "
+            << m_bankFile << endreq;
+    else
+        log << MSG::INFO << "wrote the noise bank to " << m_bankFile << endreq;
+}
+
+
+StatusCode GeneralNoiseTool::finalize() {
+    delete m_variates;
+    m_variates = 0;
+    delete m_engine;
+    m_engine = 0;
+    return StatusCode::SUCCESS;
+}
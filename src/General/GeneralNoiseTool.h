@@ -15,14 +15,19 @@
 #include "../INoiseTool.h"
 #include "TkrUtil/ITkrToTSvc.h"
 #include "../SiLayerList.h"
+#include "../SiPlaneMap.h"
 
 #include "GaudiKernel/AlgTool.h"
 #include "GaudiKernel/IDataProviderSvc.h"
+#include "GaudiKernel/MsgStream.h"
 #include "GlastSvc/GlastDetSvc/IGlastDetSvc.h"
 
 
 #include <string>
+#include <vector>
 
+class TkrDigiPhilox;
+class TkrDigiVariates;
 
 class GeneralNoiseTool : public AlgTool, virtual public INoiseTool {
 
@@ -34,6 +39,8 @@ class GeneralNoiseTool : public AlgTool, virtual public INoiseTool {
     StatusCode initialize();
     /// runs the tool
     StatusCode execute();
+    /// deletes the random engine and its variates
+    StatusCode finalize();
 
     double noiseThreshold() const { return m_noiseThreshold; }
     double dataThreshold()  const { return m_noiseThreshold; }
@@ -43,6 +50,29 @@ class GeneralNoiseTool : public AlgTool, virtual public INoiseTool {
 
  private:
 
+    /**
+     * samples a noise frame: appends the tracker-wide numbers (see
+     * sampleNoiseFrame()) and energies of the noisy strips
+     */
+    void sampleNoiseFrame(TkrDigiVariates& rand,
+                          std::vector<unsigned int>& strips,
+                          std::vector<float>& energies);
+    /// adds the strips of a noise frame to the SiPlaneMap; returns their number
+    int  mergeNoiseFrame(SiPlaneMap& siPlaneMap, const unsigned int* strips,
+                         const float* energies, const int n) const;
+    /// reads m_occupancyFile, and builds the alias table of the strips
+    StatusCode loadOccupancies(MsgStream& log);
+    /// the sum of the rates -log(1-occupancy) of all strips
+    double totalRate() const;
+    /// a checksum of the layers and of the rates of their strips
+    unsigned int modelChecksum() const;
+    /// fills the noise bank, from m_bankFile if it matches, or by sampling
+    void makeNoiseBank(MsgStream& log);
+    /// reads the noise bank from m_bankFile; false if it doesn't match
+    bool loadNoiseBank(MsgStream& log);
+    /// writes the noise bank to m_bankFile
+    void saveNoiseBank(MsgStream& log) const;
+
     /// Pointer to the event data service (aka "eventSvc")
     IDataProviderSvc* m_edSvc;
     /// Pointer to the Glast detector service
@@ -52,6 +82,8 @@ class GeneralNoiseTool : public AlgTool, virtual public INoiseTool {
 
     /// list of all SiLayers found in the detector model
     SiLayerList m_layers;
+    /// plane numbers of m_layers in the SiPlaneMap; -1 if not a tracker plane
+    std::vector<int> m_planes;
     /// energy deposit above which hit is recorded (MeV)
     double m_noiseThreshold;
     /// energy deposit above which the hit triggers (MeV);
@@ -62,6 +94,59 @@ class GeneralNoiseTool : public AlgTool, virtual public INoiseTool {
     double m_noiseOccupancy; 
     /// do full threshold analysis
     bool   m_fullThreshold;
+    /// draw the noise of each plane from its own stream, keyed by run, event
+    /// and plane, instead of from the global engine
+    bool   m_randomStreams;
+    /// seed selecting the set of streams, if m_randomStreams
+    int    m_streamSeed;
+    /// the engine of the streams, if m_randomStreams
+    TkrDigiPhilox* m_engine;
+    /// the variates of m_engine
+    TkrDigiVariates* m_variates;
+    /**
+     * number of noise frames to sample at initialize.  Each event then adds
+     * the noisy strips of a random frame, instead of sampling them.  The
+     * frames repeat, about every m_bankSize events.  0 samples every event.
+     */
+    int         m_bankSize;
+    /**
+     * file of the noise bank.  It's read if it exists and was made with the
+     * same layers, occupancies and threshold, otherwise written after
+     * sampling.
+     */
+    std::string m_bankFile;
+    /// the noisy strips of all frames of the bank, one after the other
+    std::vector<unsigned int> m_bankStrips;
+    /// the energies of m_bankStrips
+    std::vector<float>        m_bankEnergies;
+    /// the first strip of each frame, and the end of the last one
+    std::vector<int>          m_bankFirst;
+    /**
+     * file of per-strip occupancies.  Each line, after # comments, gives
+     * "tower layer view firstStrip lastStrip occupancy" for a range of
+     * strips, e.g. a chip; the other strips have m_noiseOccupancy.
+     */
+    std::string m_occupancyFile;
+    /// lists the strips flagged below threshold, for debugging
+    bool   m_printRemoved;
+    /**
+     * Walker alias table of the strips, by tracker-wide number, if there is
+     * an occupancy file: strip i is taken with probability m_aliasProb[i],
+     * m_alias[i] otherwise
+     */
+    std::vector<float>        m_aliasProb;
+    std::vector<unsigned int> m_alias;
+    /// the sum of the strip rates of the alias table
+    double                    m_aliasRate;
+    /// a checksum of the strip rates of the alias table
+    unsigned int              m_aliasChecksum;
+    /// flags the strips already in the frame being sampled; all 0 between
+    /// frames
+    std::vector<char>         m_inFrame;
+    /// the noise frame of the event, if there is no bank
+    std::vector<unsigned int> m_frameStrips;
+    /// the energies of m_frameStrips
+    std::vector<float>        m_frameEnergies;
 
 };
 
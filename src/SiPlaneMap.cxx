@@ -0,0 +1,86 @@
+/**
+ * @file SiPlaneMap.cxx
+ *
+ * @brief Maps the silicon planes of the tracker to their SiStripLists.
+ *
+ * $Header$
+ */
+
+#include "SiPlaneMap.h"
+
+
+int SiPlaneMap::planeIndex(const idents::VolumeIdentifier& id)
+{
+    // Purpose and Method: decodes tower, bilayer and view of a plane id
+    // Inputs: volume identifier of a plane (or of a wafer in it)
+    // Outputs: plane number, -1 if id isn't a tracker plane
+    // Dependencies: none
+
+    const TkrPlaneKey key(id);
+    if ( !key.isValid() )
+        return -1;
+    const int layer = key.layer();
+    if ( layer<0 || layer>=nLayers )
+        return -1;
+    return planeIndex(key.tower(), layer, key.view());
+}
+
+
+SiPlaneMap::iterator SiPlaneMap::insert(const int plane,
+                                        const idents::VolumeIdentifier& id,
+                                        SiStripList* list)
+{
+    // Purpose and Method: enters a plane into the occupied list, keeping the
+    //                     list in plane-number order
+    // Inputs: plane number, volume identifier, SiStripList
+    // Outputs: iterator to the plane
+    // Dependencies: none
+    // Restrictions and Caveats: invalidates iterators
+
+    if ( m_slot[plane] >= 0 )
+        return m_planes.begin() + m_slot[plane];
+
+    // planes tend to come in order, so search from the back
+    int pos = m_index.size();
+    while ( pos>0 && m_index[pos-1]>plane )
+        --pos;
+    m_planes.insert(m_planes.begin()+pos, value_type(id, list));
+    m_index.insert(m_index.begin()+pos, static_cast<short>(plane));
+    m_keys.insert(m_keys.begin()+pos,
+                  TkrPlaneKey::encodeLayer(tower(plane), layer(plane),
+                                           view(plane)));
+    const int size = m_index.size();
+    for ( int i=pos; i<size; ++i )
+        m_slot[m_index[i]] = i;
+
+    return m_planes.begin() + pos;
+}
+
+
+SiStripList*& SiPlaneMap::operator[](const idents::VolumeIdentifier& id)
+{
+    // Purpose and Method: std::map-like access
+    // Inputs: volume identifier of a plane
+    // Outputs: reference to the SiStripList pointer of the plane
+    // Dependencies: none
+    // Restrictions and Caveats: for an id which isn't a tracker plane, the
+    //                           reference is to a pointer outside the map
+
+    const int plane = planeIndex(id);
+    if ( plane < 0 ) {
+        m_invalid = 0;
+        return m_invalid;
+    }
+    return insert(plane, id, 0)->second;
+}
+
+
+void SiPlaneMap::clear()
+{
+    m_planes.clear();
+    m_index.clear();
+    m_keys.clear();
+    for ( int i=0; i<nPlanes; ++i )
+        m_slot[i] = -1;
+    m_invalid = 0;
+}
@@ -0,0 +1,141 @@
+/**
+ * @class SiPlaneMap
+ *
+ * @brief Maps the silicon planes of the tracker to their SiStripLists.
+ *
+ * The tracker has a fixed number of planes (16 towers x 18 bilayers x 2
+ * views), so instead of a std::map keyed by volume identifiers, SiPlaneMap
+ * uses a flat table indexed by a plane number.  The occupied planes are
+ * kept in a list, in plane-number order, which is what the iterators walk.
+ * The plane number runs over towers, then bilayers, and within a bilayer
+ * the two planes come in tray order.  This is the order the std::map keyed
+ * by volume identifier had.
+ *
+ * The interface is that of the std::map it replaces: an iterator points to
+ * a pair of the volume identifier of the plane and the SiStripList.  The
+ * volume identifier is the one the plane was entered with.  Unlike a
+ * std::map, entering a new plane invalidates the iterators.  The map does
+ * not own the SiStripLists.
+ *
+ * $Header$
+ */
+
+#ifndef __SIPLANEMAP_H__
+#define __SIPLANEMAP_H__
+
+#include "TkrPlaneKey.h"
+
+#include "idents/VolumeIdentifier.h"
+
+#include <utility>
+#include <vector>
+
+class SiStripList;
+
+
+class SiPlaneMap {
+
+ public:
+
+    typedef std::pair<idents::VolumeIdentifier, SiStripList*> value_type;
+    typedef std::vector<value_type>::iterator       iterator;
+    typedef std::vector<value_type>::const_iterator const_iterator;
+
+    enum { nTowers=16, nLayers=18, nViews=2, nPlanes=nTowers*nLayers*nViews };
+
+    SiPlaneMap() { clear(); }
+
+    /// plane number of a tower, bilayer and view
+    static int planeIndex(const int tower, const int layer, const int view) {
+        return ( tower * nLayers + layer ) * nViews
+            + ( layer%2 == 0 ? 1 - view : view );
+    }
+    /**
+     * plane number of a volume identifier
+     * @return the plane number, or -1 if id isn't a tracker plane
+     */
+    static int planeIndex(const idents::VolumeIdentifier& id);
+    /// plane number of a plane key, -1 if the key is invalid
+    static int planeIndex(const TkrPlaneKey& key) {
+        return key.isValid()
+            ? planeIndex(key.tower(), key.layer(), key.view()) : -1;
+    }
+
+    /// tower of a plane number
+    static int tower(const int plane) { return plane / ( nLayers * nViews ); }
+    /// bilayer of a plane number
+    static int layer(const int plane) { return ( plane / nViews ) % nLayers; }
+    /// view of a plane number
+    static int view(const int plane) {
+        const int k = plane % nViews;
+        return layer(plane)%2 == 0 ? 1 - k : k;
+    }
+
+    iterator       begin()       { return m_planes.begin(); }
+    iterator       end()         { return m_planes.end(); }
+    const_iterator begin() const { return m_planes.begin(); }
+    const_iterator end()   const { return m_planes.end(); }
+
+    /// number of occupied planes
+    unsigned int size() const { return m_planes.size(); }
+    bool empty()        const { return m_planes.empty(); }
+
+    /// plane number of an occupied plane
+    int indexOf(const const_iterator it) const {
+        return m_index[it - m_planes.begin()];
+    }
+
+    /// plane key of an occupied plane
+    TkrPlaneKey key(const const_iterator it) const {
+        return TkrPlaneKey(m_keys[it - m_planes.begin()]);
+    }
+
+    /// the SiStripList of a plane number, or 0 if the plane isn't occupied
+    SiStripList* plane(const int plane) const {
+        const int slot = m_slot[plane];
+        return slot<0 ? 0 : m_planes[slot].second;
+    }
+
+    iterator find(const int plane) {
+        const int slot = plane<0 ? -1 : m_slot[plane];
+        return slot<0 ? end() : m_planes.begin() + slot;
+    }
+    iterator find(const idents::VolumeIdentifier& id) {
+        return find(planeIndex(id));
+    }
+
+    /**
+     * enters a plane, unless it is already there
+     * @param plane  plane number
+     * @param id     volume identifier of the plane
+     * @param list   SiStripList of the plane
+     * @return       iterator to the plane
+     */
+    iterator insert(const int plane, const idents::VolumeIdentifier& id,
+                    SiStripList* list);
+
+    /**
+     * Returns the SiStripList of a plane, entering the plane with a null
+     * pointer if it isn't there.  id must be a tracker plane id.
+     */
+    SiStripList*& operator[](const idents::VolumeIdentifier& id);
+
+    /// empties the map; doesn't delete the SiStripLists
+    void clear();
+
+ private:
+
+    /// the occupied planes, in plane-number order
+    std::vector<value_type> m_planes;
+    /// plane number of each occupied plane
+    std::vector<short>      m_index;
+    /// plane key of each occupied plane
+    std::vector<TkrPlaneKey::key_type> m_keys;
+    /// position in m_planes, per plane number; -1 if not occupied
+    short                   m_slot[nPlanes];
+    /// target of operator[] for ids that aren't tracker planes
+    SiStripList*            m_invalid;
+
+};
+
+#endif
@@ -15,28 +15,26 @@
 #define __SIPLANEMAPCONTAINER_H__
 
 #include "SiStripList.h"
-
-#include "idents/VolumeIdentifier.h"
+#include "SiPlaneMap.h"
+#include "SiStripListPool.h"
 
 #include "GaudiKernel/DataObject.h"
 
-#include <map>
-
 
 class SiPlaneMapContainer : public DataObject {
 
  public:
  
-    typedef std::map<idents::VolumeIdentifier, SiStripList*> SiPlaneMap;
+    typedef ::SiPlaneMap SiPlaneMap;
 
     /// Initializes the container with a SiPlaneMap
-    SiPlaneMapContainer(const SiPlaneMap m): m_siPlaneMap(m) {}
+    SiPlaneMapContainer(const SiPlaneMap& m): m_siPlaneMap(m) {}
 
-    /// Deletes the contained SiStripLists
+    /// Gives the contained SiStripLists back to the SiStripListPool
     SiPlaneMapContainer::~SiPlaneMapContainer() {
         for ( SiPlaneMap::iterator it=m_siPlaneMap.begin();
               it!=m_siPlaneMap.end(); ++it ) {
-            delete (*it).second;
+            SiStripListPool::release((*it).second);
             (*it).second = 0;
         }
         m_siPlaneMap.clear();
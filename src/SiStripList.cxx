@@ -11,11 +11,10 @@
 
 #include "SiStripList.h"
 #include "General/GeneralNoiseTool.h"
+#include "TkrDigiVariates.h"
+#include "TkrDigiArena.h"
 
-#include "CLHEP/Random/RandFlat.h"
-#include "CLHEP/Random/RandGauss.h"
 #include "CLHEP/Random/RandBinomial.h"
-#include "CLHEP/Random/RandLandau.h"
 
 #include <algorithm>
 #include <float.h>
@@ -28,9 +27,19 @@ inline double copysign(double a, double b){return _copysign(a,b);}
 #endif
 
 namespace {
-    bool debug = false;
     bool printEdep = true;
     bool doLandau = true;
+
+    /// reorders a strip column; row i of the result is row rows[i] of col
+    template<class T> void gather(std::vector<T>& col,
+                                  const std::vector<int>& rows)
+    {
+        const int size = rows.size();
+        std::vector<T> out(size);
+        for ( int i=0; i<size; ++i )
+            out[i] = col[rows[i]];
+        col.swap(out);
+    }
 }
 
 // static variable implementations--now initialized with detsvc.
@@ -43,6 +52,23 @@ double  SiStripList::s_guard_ring    = 0.0; // 0.974;
 double  SiStripList::s_ssd_gap       = 0.0; // 0.025;            
 double  SiStripList::s_ladder_gap    = 0.0; // 0.200;
 
+bool    SiStripList::s_stripTable    = false;
+int     SiStripList::s_n_strips      = 0;
+std::vector<double> SiStripList::s_stripCentre;
+double  SiStripList::s_panel_half    = 0.0;
+double  SiStripList::s_ladder_pitch  = 0.0;
+double  SiStripList::s_active_width  = 0.0;
+double  SiStripList::s_strip_pitch   = 0.0;
+
+bool    SiStripList::s_activeArea       = false;
+bool    SiStripList::s_checkActiveArea  = false;
+bool    SiStripList::s_printRemoved     = false;
+long    SiStripList::s_activeChecks     = 0;
+long    SiStripList::s_activeMismatches = 0;
+double  SiStripList::s_active_half      = 0.0;
+double  SiStripList::s_panel_half_y     = 0.0;
+double  SiStripList::s_ssd_pitch        = 0.0;
+
 
 StatusCode SiStripList::initialize(IGlastDetSvc* ds/*, ITkrToTSvc* ts*/) 
 {
@@ -70,32 +96,156 @@ StatusCode SiStripList::initialize(IGlastDetSvc* ds/*, ITkrToTSvc* ts*/)
         return StatusCode::FAILURE;
     s_guard_ring = 0.5 * (s_die_width - temp);
 
+    s_stripTable = buildStripTable();
+    s_activeArea = buildActiveArea();
+
     return StatusCode::SUCCESS;
 }
 
 
+bool SiStripList::buildActiveArea()
+{
+    // Purpose and Method: derives the active area of the wafers from the
+    //                     constants read in initialize().  A wafer's active
+    //                     area is a square of side SiWaferActiveSide, centred
+    //                     on the wafer.  Ladders are placed at a pitch of
+    //                     die_width() + ladder_gap() in x, wafers at a pitch
+    //                     of die_width() + ssd_gap() in y.  The distances are
+    //                     checked against the service on a fine grid across
+    //                     the plane and somewhat beyond.
+    // Inputs: none
+    // Outputs: true if the distances agree with the service
+    // Dependencies: the constants have to be read first
+    // Restrictions and Caveats: assumes as many wafers per ladder as ladders,
+    //                           as SimpleMcToHitTool does
+
+    s_activeArea    = false;
+    s_active_half   = 0.5 * die_width() - guard_ring();
+    s_ssd_pitch     = die_width() + ssd_gap();
+    s_panel_half_y  = 0.5 * ( n_si_dies() * die_width()
+                              + ( n_si_dies() - 1 ) * ssd_gap() );
+    if ( s_n_si_dies <= 0 || s_active_half <= 0 )
+        return false;
+
+    const double tolerance = 1.e-6;
+    const double step = 0.1 * si_strip_pitch();
+    double u;
+    for ( u=-s_panel_half-2.0; u<=s_panel_half+2.0; u+=step ) {
+        const HepPoint3D p(u, 0., 0.);
+        if ( fabs(s_detSvc->insideActiveLocalX(p) - activeX(u)) > tolerance )
+            return false;
+    }
+    for ( u=-s_panel_half_y-2.0; u<=s_panel_half_y+2.0; u+=step ) {
+        const HepPoint3D p(0., u, 0.);
+        if ( fabs(s_detSvc->insideActiveLocalY(p) - activeY(u)) > tolerance )
+            return false;
+    }
+    return true;
+}
+
+
+bool SiStripList::buildStripTable()
+{
+    // Purpose and Method: derives the strip geometry from the constants read
+    //                     in initialize(), and fills the strip-centre table.
+    //                     The table holds the positions as the detector
+    //                     service gives them.  The analytic positions and
+    //                     stripId() are checked against the service: at each
+    //                     strip centre, close to both edges of each strip, in
+    //                     the gaps, and off the plane.
+    // Inputs: none
+    // Outputs: true if the geometry agrees with the service
+    // Dependencies: the constants have to be read first
+    // Restrictions and Caveats: if the check fails, calculateBin() and
+    //                           stripId() keep calling the service
+
+    s_stripTable   = false;
+    s_n_strips     = n_si_strips();
+    s_panel_half   = 0.5 * panel_width();
+    s_ladder_pitch = die_width() + ladder_gap();
+    s_active_width = die_width() - 2.0 * guard_ring();
+    s_strip_pitch  = si_strip_pitch();
+    if ( s_n_strips <= 0 || s_strip_pitch <= 0 )
+        return false;
+
+    // positions agree if they are the same within this tolerance (mm)
+    const double tolerance = 1.e-6;
+    s_stripCentre.resize(s_n_strips);
+    int strip;
+    for ( strip=0; strip<s_n_strips; ++strip ) {
+        const double x = s_detSvc->stripLocalX(strip);
+        const int die = strip / s_stripPerWafer;
+        const double xCalc = -s_panel_half + die * s_ladder_pitch
+            + s_guard_ring + ( strip%s_stripPerWafer + 0.5 ) * s_strip_pitch;
+        if ( fabs(x - xCalc) > tolerance )
+            return false;
+        s_stripCentre[strip] = x;
+    }
+
+    // stripId() is used from here on, so turn the table on for the check
+    s_stripTable = true;
+    bool ok = true;
+    const double edge = 0.49 * s_strip_pitch;
+    for ( strip=0; ok && strip<s_n_strips; ++strip ) {
+        const double x = s_stripCentre[strip];
+        ok = static_cast<int>(s_detSvc->stripId(x)) == stripId(x)
+            && static_cast<int>(s_detSvc->stripId(x-edge)) == stripId(x-edge)
+            && static_cast<int>(s_detSvc->stripId(x+edge)) == stripId(x+edge);
+    }
+    for ( int die=0; ok && die<=s_n_si_dies; ++die ) {
+        // the middle of the gap left of each ladder, and off the plane
+        const double x = -s_panel_half + die * s_ladder_pitch
+            - 0.5 * ladder_gap();
+        ok = static_cast<int>(s_detSvc->stripId(x)) == stripId(x)
+            && static_cast<int>(s_detSvc->stripId(x-1.0)) == stripId(x-1.0)
+            && static_cast<int>(s_detSvc->stripId(x+1.0)) == stripId(x+1.0);
+    }
+    s_stripTable = ok;
+    return ok;
+}
+
+
 #ifndef TEMPLATE
 void SiStripList::addStrip(const int strip, double dE,
                            const hitList* hits,
                            int t1, int t2) 
 {
-    // Purpose and Method: adds a strip to the list of strips.  To add all
-    //                     McPositionHits, addStrip is called several times.  To
-    //                     avoid that the energy is added each time, it is set
-    //                     to 0 after the first call.
+    // Purpose and Method: adds a strip to the list of strips.  The strip is
+    //                     looked up once, with the first McPositionHit
+    //                     deciding on the noise flag, as if addStrip was
+    //                     called for each hit with the energy and times
+    //                     going with the first call only.
     // Inputs: strip id, energy deposit, vector of McPositionHits, ToT start and
     //         stop time
     // Outputs: none
     // Dependencies: none
-    // Restrictions and Caveats: Icky coding.  Actually, it would be better if
-    //                           addStrip would be a template for both a hit and
-    //                           a list of hits.
+    // Restrictions and Caveats: an empty hit list adds nothing
 
-    for ( hitList::const_iterator it=hits->begin(); it!=hits->end(); ++it ) {
-        addStrip(strip, dE, *it, t1, t2);
-        dE = 0;
-        t1 = t2 = -1;
-    }
+    if ( hits->empty() )
+        return;
+    addStrip(strip, dE, &hits->front(), &hits->front() + hits->size(), t1, t2);
+}
+
+
+void SiStripList::addStrip(const int strip, const double dE,
+                           Event::McPositionHit* const* first,
+                           Event::McPositionHit* const* last,
+                           const int t1, const int t2)
+{
+    // Purpose and Method: as addStrip with a hitList, for a range of hits
+    // Inputs: strip id, energy deposit, range of McPositionHits, ToT start and
+    //         stop time
+    // Outputs: none
+    // Dependencies: none
+    // Restrictions and Caveats: an empty range adds nothing
+
+    if ( first == last )
+        return;
+    const int pos = findOrAddRow(strip, dE, *first, t1, t2);
+    if ( pos < 0 )
+        return;
+    for ( ; first!=last; ++first )
+        addHit(pos, *first);
 }
 
 
@@ -120,8 +270,30 @@ export template<class T> void SiStripList::addStrip(const int strip,
     // Restrictions and Caveats: addStrip should be a template for both a hit
     //                           and a list of hits
 
+    const int pos = findOrAddRow(strip, dE, hit, t1, t2);
+    if ( pos >= 0 )
+        addHit(pos, hit);
+}
+
+
+int SiStripList::findOrAddRow(const int strip, const double dE,
+                              const Event::McPositionHit* hit,
+                              const int t1, const int t2)
+{
+    // Purpose and Method: adds energy and times to the row of a strip, and
+    //                     creates the row if the strip is new
+    // Inputs: strip id, energy deposit, pointer to McPositionHit (0 for
+    //         noise), ToT start and stop time
+    // Outputs: the row of the strip, or -1 if the strip doesn't exist
+    // Dependencies: none
+    // Restrictions and Caveats: the hit itself is not added
+
     if ( strip == Strip::undef_strip() )
-        return;
+        return -1;
+    // The Bari current window can reach past the first strip of a plane.
+    // Such strips don't exist, and they have no slot in the strip table.
+    if ( strip < 0 || strip >= n_si_strips() )
+        return -1;
 
     // Real hits should have McPositionHits associated.  If hit is empty,
     // addStrip labels the strip as noise.
@@ -135,25 +307,260 @@ export template<class T> void SiStripList::addStrip(const int strip,
     // If there are none (e.g. the strip is from McToHitSimpleTool),
     // electronic noise has to be added later.
 
-    // search list for strip
-    for ( iterator s=begin(); s!=end(); ++s ) {
-        const int index = s->index();
-        if ( index < strip )
-            continue;
-        if ( strip == index ) {
-            s->addEnergy(dE);
-            if (hit!=0) s->addHit(hit);
-            s->addTime(t1, t2);
-            return;
+    if ( !m_dense && m_index.size() >= s_denseThreshold )
+        makeDense();
+
+    int pos;
+    if ( m_dense ) {
+        // accumulator mode: O(1) lookup in the strip table, new strips are
+        // appended and put in order by compact()
+        if ( isOccupied(strip) ) {
+            pos = m_slot[strip];
+            m_energy[pos] += dE;
+            addTime(pos, t1, t2);
+            return pos;
+        }
+        m_occupancy[strip>>5] |= 1u << (strip&31);
+        pos = appendRow(strip, dE, noise, elecNoise, t1, t2);
+        m_slot[strip] = pos;
+        if ( strip < m_lastIndex )
+            m_sorted = false;
+        m_lastIndex = strip;
+        return pos;
+    }
+
+    // small sorted form: search list for strip
+    int lo = 0, hi = m_index.size();
+    while ( lo < hi ) {
+        const int mid = (lo + hi) / 2;
+        if ( m_index[mid] < strip )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    pos = lo;
+    if ( pos < size() && m_index[pos] == strip ) {
+        m_energy[pos] += dE;
+        addTime(pos, t1, t2);
+        return pos;
+    }
+    // else ... add before the next, to keep in order of the index
+    insertRow(pos, strip, dE, noise, elecNoise, t1, t2);
+    return pos;
+}
+
+
+int SiStripList::appendRow(const int strip, const double dE, const bool noise,
+                           const bool elecNoise, const int t1, const int t2)
+{
+    // Purpose and Method: appends a strip to all columns.  The hit chain of
+    //                     the new row is empty.
+    // Inputs: strip id, energy deposit, noise flags, ToT start and stop time
+    // Outputs: position of the new row
+    // Dependencies: none
+
+    const int pos = m_index.size();
+    m_index.push_back(strip);
+    m_energy.push_back(dE);
+    m_status.push_back(GOOD);
+    m_time1.push_back(t1);
+    m_time2.push_back(t2);
+    m_flags.push_back((noise ? NOISE : 0) | (elecNoise ? ELECNOISE : 0));
+    m_hitHead.push_back(-1);
+    m_hitTail.push_back(-1);
+    return pos;
+}
+
+
+void SiStripList::insertRow(const int pos, const int strip, const double dE,
+                            const bool noise, const bool elecNoise,
+                            const int t1, const int t2)
+{
+    // Purpose and Method: inserts a strip into all columns before row pos.
+    //                     The hit chain of the new row is empty.
+    // Inputs: position, strip id, energy deposit, noise flags, ToT start and
+    //         stop time
+    // Outputs: none
+    // Dependencies: none
+
+    m_index.insert(m_index.begin()+pos, strip);
+    m_energy.insert(m_energy.begin()+pos, static_cast<float>(dE));
+    m_status.insert(m_status.begin()+pos, static_cast<int>(GOOD));
+    m_time1.insert(m_time1.begin()+pos, t1);
+    m_time2.insert(m_time2.begin()+pos, t2);
+    m_flags.insert(m_flags.begin()+pos,
+        static_cast<unsigned char>((noise ? NOISE : 0) | (elecNoise ? ELECNOISE : 0)));
+    m_hitHead.insert(m_hitHead.begin()+pos, -1);
+    m_hitTail.insert(m_hitTail.begin()+pos, -1);
+}
+
+
+void SiStripList::makeDense()
+{
+    // Purpose and Method: switches the list to accumulator mode.  The strip
+    //                     table is sized once and reused; only the occupancy
+    //                     bitmap has to be cleared.
+    // Inputs: none
+    // Outputs: none
+    // Dependencies: n_si_strips() must be known (initialize() was called)
+
+    const int nStrips = n_si_strips();
+    if ( static_cast<int>(m_slot.size()) < nStrips ) {
+        m_slot.resize(nStrips);
+        m_occupancy.resize((nStrips+31)/32);
+    }
+    std::fill(m_occupancy.begin(), m_occupancy.end(), 0u);
+
+    // the list is sorted at this point
+    const int size = m_index.size();
+    for ( int i=0; i<size; ++i ) {
+        const int strip = m_index[i];
+        m_occupancy[strip>>5] |= 1u << (strip&31);
+        m_slot[strip] = i;
+    }
+    m_lastIndex = size>0 ? m_index.back() : -1;
+    m_sorted    = true;
+    m_dense     = true;
+}
+
+
+void SiStripList::compact()
+{
+    // Purpose and Method: puts the strips appended in accumulator mode into
+    //                     index order, walking the occupancy bitmap.
+    // Inputs: none
+    // Outputs: none
+    // Dependencies: none
+    // Restrictions and Caveats: invalidates iterators
+
+    if ( m_sorted )
+        return;
+
+    // new row of each strip, from the bitmap
+    int row = 0;
+    const int nWords = m_occupancy.size();
+    for ( int w=0; w<nWords; ++w ) {
+        unsigned int word = m_occupancy[w];
+        for ( int bit=0; word!=0; ++bit, word>>=1 ) {
+            if ( (word&1u) != 0 )
+                m_slot[32*w + bit] = row++;
         }
-        // else ... add before the next, to keep in order of the index
-        insert(s, Strip(strip, dE, noise, hit, elecNoise, t1, t2));
+    }
+    // old row of each new row; m_index still holds the old order
+    const int size = m_index.size();
+    std::vector<int> rows(size);
+    for ( int i=0; i<size; ++i )
+        rows[m_slot[m_index[i]]] = i;
+
+    gather(m_index,  rows);
+    gather(m_energy, rows);
+    gather(m_status, rows);
+    gather(m_time1,  rows);
+    gather(m_time2,  rows);
+    gather(m_flags,  rows);
+    // the hits stay where they are in the arena
+    gather(m_hitHead, rows);
+    gather(m_hitTail, rows);
+
+    m_lastIndex = m_index.back();
+    m_sorted    = true;
+}
+
+
+void SiStripList::clear()
+{
+    // Purpose and Method: empties the list, and falls back to the small sorted
+    //                     form.  The capacity of the strip table is retained.
+    // Inputs: none
+    // Outputs: none
+    // Dependencies: none
+
+    m_index.clear();
+    m_energy.clear();
+    m_status.clear();
+    m_time1.clear();
+    m_time2.clear();
+    m_flags.clear();
+    m_hitHead.clear();
+    m_hitTail.clear();
+    m_hitArena.clear();
+    m_hitNext.clear();
+    m_hitsPacked = true;
+    m_dense     = false;
+    m_sorted    = true;
+    m_lastIndex = -1;
+}
+
+
+void SiStripList::packHits()
+{
+    // Purpose and Method: rewrites the hit arena such that the hits of each
+    //                     strip are contiguous, and removes duplicate hits of
+    //                     a strip.  The first occurrence of a hit is kept, so
+    //                     the order is the order the hits were added in.
+    // Inputs: none
+    // Outputs: none
+    // Dependencies: none
+    // Restrictions and Caveats: invalidates hit iterators
+
+    if ( m_hitsPacked )
         return;
+
+    hitList& packed = m_hitScratch;
+    packed.clear();
+    packed.reserve(m_hitArena.size());
+    const int size = m_index.size();
+    for ( int i=0; i<size; ++i ) {
+        int link = m_hitHead[i];
+        if ( link < 0 )
+            continue;
+        const int first = packed.size();
+        for ( ; link>=0; link=m_hitNext[link] ) {
+            Event::McPositionHit* hit = m_hitArena[link];
+            if ( std::find(packed.begin()+first, packed.end(), hit)
+                 == packed.end() )
+                packed.push_back(hit);
+        }
+        m_hitHead[i] = first;
+        m_hitTail[i] = packed.size() - 1;
+    }
+    m_hitArena.swap(packed);
+
+    // chain each strip's hits in sequence, for later additions
+    const int nHits = m_hitArena.size();
+    m_hitNext.resize(nHits);
+    for ( int link=0; link<nHits; ++link )
+        m_hitNext[link] = link + 1;
+    for ( int i=0; i<size; ++i ) {
+        if ( m_hitTail[i] >= 0 )
+            m_hitNext[m_hitTail[i]] = -1;
     }
+    m_hitsPacked = true;
+}
+
 
-    // If the strip isn't in the list yet, and no others have higher ids, 
-    // add it to the end of the list.
-    push_back(Strip(strip, dE, noise, hit, elecNoise, t1, t2));
+bool SiStripList::hasStrip(const int strip) const
+{
+    // Purpose and Method: checks if a strip is in the list, via the bitmap in
+    //                     accumulator mode, or a binary search otherwise.
+    // Inputs: strip id
+    // Outputs: true if the strip is in the list
+    // Dependencies: none
+
+    if ( strip < 0 || strip >= n_si_strips() )
+        return false;
+    if ( m_dense )
+        return isOccupied(strip);
+
+    int lo = 0, hi = m_index.size();
+    while ( lo < hi ) {
+        const int mid = (lo + hi) / 2;
+        if ( m_index[mid] < strip )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < size() && m_index[lo] == strip;
 }
 
 
@@ -162,7 +569,9 @@ void SiStripList::score(const HepPoint3D& o, const HepPoint3D& p,
                         bool fluctuate = false, bool test = false) 
 {
     // Purpose and Method: distribute energy among the various strips as the
-    //                     particle passes through the detector.
+    //                     particle passes through the detector.  The segment
+    //                     is clipped to the active area, and scored by
+    //                     scoreClipped().
     // Inputs: entry and exit point (in local coordinates), and a pointer to a
     //         McPositionHit. If "test" is true, a constant 0.155 MeV is deposited.
     // Outputs: none
@@ -175,16 +584,36 @@ void SiStripList::score(const HepPoint3D& o, const HepPoint3D& p,
     HepVector3D inVec  = o;
     HepVector3D outVec = p;
 
-    //store the stuff to add energies at the end;
-    // brute force, should be a little class
-    std::vector<float> eVec(0);  // eDep for strip
-    std::vector<int>   idVec(0); // iD of strip
-    std::vector<const Event::McPositionHit*> hitVec(0); // Mc pos hit
-
     // the method can modify all the arguments
     bool trimmed;
     if(!isActiveHit(inVec, outVec, eLoss, trimmed)) return;
 
+    scoreClipped(inVec, outVec, eLoss, hit, fluctuate, test);
+}
+
+
+void SiStripList::scoreClipped(const HepVector3D& inVec,
+                               const HepVector3D& outVec, double eLoss,
+                               const Event::McPositionHit* hit, 
+                               bool fluctuate, bool test,
+                               TkrDigiVariates* rand) 
+{
+    // Purpose and Method: distributes the energy loss of a segment which is
+    //                     in the active area.  The strips crossed form a run:
+    //                     the entry and exit strips get a fraction of the
+    //                     energy, the strips in between the same full share.
+    //                     The run is deposited in one go.
+    // Inputs: entry and exit point (in plane coordinates), the energy loss in
+    //         the active area, and a pointer to a McPositionHit.  If "test"
+    //         is true, 0.155 MeV per strip width crossed are deposited.
+    //         The fluctuations are drawn from rand, or from the global
+    //         variates if it is 0.
+    // Outputs: none
+    // Dependencies: none
+    // Restrictions and Caveats: may run concurrently for different lists if
+    //                           the strip table is on and each thread has
+    //                           its own variates
+
     HepVector3D dir = outVec - inVec;
     float dTot = dir.mag();
 
@@ -211,232 +640,341 @@ void SiStripList::score(const HepPoint3D& o, const HepPoint3D& p,
     // die of silicon strips (or multiple dies) then exits through another
     // gap. This is highly unlikely.
 
-    if ( ins == Strip::undef_strip() ) {        // entered in a gap
-
-        if ( exs != Strip::undef_strip() ) {        // exited through a strip
-            float sx = calculateBin(exs);
-            // fraction of strip crossed
-            float dx = si_strip_pitch() / 2.0 + (ex-sx) * copysign(1.0, xDir);
-            float frac = (test ? 1.0 : dx / dx_max);
-            //addStrip(exs, dE*frac, hit);
-            idVec.push_back(exs);
-            eVec.push_back(dE*frac);
-            hitVec.push_back(hit);
-            if(eVec.size()!=idVec.size()){
-                std::cout << eVec.size() << " " << idVec.size() << std::endl;
-            }
-
+    // The run is described by its first strip in fill order, the step
+    // and the number of strips.  The fill order used to be: the strip with
+    // the fractional deposit, then the others walking away from it; for
+    // case 4 the entry strip, the exit strip, and then the strips between.
+    // The Landau fluctuations are drawn in this order.
+    int   start;
+    short step = 1;
+    int   nRun = 1;
+    bool  bothEnds = false;
+    bool  oneStrip = false;
+    float frac = 1.0;
 
-            short sinc = (xDir>0) ? -1 : 1; // move backwards (exit strip)
-            for ( int sid=exs+sinc;
-                (sid>=0)
-                && (sid<n_si_strips())
-                &&
-                (
-                xDir>0 ? (in<calculateBin(sid)) : (in>calculateBin(sid))
-                );
-            sid+=sinc ) {
-                //addStrip(sid, dE, hit);
-                idVec.push_back(sid);
-                eVec.push_back(dE);
-                hitVec.push_back(hit);
-                if(eVec.size()!=idVec.size()){
-                    std::cout << eVec.size() << " " << idVec.size() << std::endl;
-                }
-            }
+    if ( ins == Strip::undef_strip() ) {        // entered in a gap
 
- 
-            // scans for until it crosses the entered gap
-        }
-        else
+        if ( exs == Strip::undef_strip() )
             return;  // entered & exited through a gap (assume no strips hit)
+
+        // exited through a strip
+        float sx = calculateBin(exs);
+        // fraction of strip crossed
+        float dx = si_strip_pitch() / 2.0 + (ex-sx) * copysign(1.0, xDir);
+        frac = (test ? 1.0 : dx / dx_max);
+
+        start = exs;
+        step  = (xDir>0) ? -1 : 1; // move backwards (exit strip)
+        // scans for until it crosses the entered gap
+        for ( int sid=exs+step;
+            (sid>=0)
+            && (sid<n_si_strips())
+            &&
+            (
+            xDir>0 ? (in<calculateBin(sid)) : (in>calculateBin(sid))
+            );
+        sid+=step )
+            ++nRun;
     }
     else {
+        start = ins;
         if ( exs == Strip::undef_strip() ) {        // exited through a gap
             float sx = calculateBin(ins);
             // fraction of strip crossed
             float dx = si_strip_pitch() / 2.0 - (in-sx) * copysign(1.0, xDir);
-            float frac = ( test ? 1.0 : dx / dx_max);
-            //addStrip(ins, dE*frac, hit);
-            idVec.push_back(ins);
-            eVec.push_back(dE*frac);
-            hitVec.push_back(hit);
-            if(eVec.size()!=idVec.size()){
-                std::cout << eVec.size() << " " << idVec.size() << std::endl;
-            }
-
+            frac = ( test ? 1.0 : dx / dx_max);
 
-            short sinc = (xDir>0) ? 1 : -1;   // move backwards (exit strip)
-            for ( int sid=ins+sinc;
+            step = (xDir>0) ? 1 : -1;   // move backwards (exit strip)
+            // scans for until it crosses the exited gap
+            for ( int sid=ins+step;
                 (sid>=0)
                 && (sid<n_si_strips())
                 && 
                 (
                 xDir>0 ? (ex>calculateBin(sid)) : (ex<calculateBin(sid))
                 );
-            sid+=sinc ) {
-                //addStrip(sid, dE, hit);
-                idVec.push_back(sid);
-                eVec.push_back(dE);
-                hitVec.push_back(hit);
-                if(eVec.size()!=idVec.size()){
-                    std::cout << eVec.size() << " " << idVec.size() << std::endl;
-                }
-            }
+            sid+=step )
+                ++nRun;
+        }
+        else if ( ins == exs ) {     // entered + exited through strips
+            oneStrip = true;
+        }
+        else {
+            bothEnds = true;
+            step = (ins<exs) ? 1 : -1;
+            nRun = (exs-ins)*step + 1;
+        }
+    }
 
+    // energies of the run, indexed by strip id - first
+    const int first = step>0 ? start : start - (nRun-1);
+    m_runEnergy.assign(nRun, dE);
+    float* eRun = &m_runEnergy[0];
+    if ( oneStrip ) {
+        eRun[0] = eLoss;
+    }
+    else if ( !bothEnds ) {
+        eRun[start-first] = dE*frac;
+    }
+    else {
+        float sx = calculateBin(ins);
+        float dx = si_strip_pitch() / 2. - (in-sx) * copysign(1., xDir);
+        frac = ( test ? 1.0 : dx / dx_max);
+        eRun[ins-first] = dE*frac;   // entry strip
+
+        sx = calculateBin(exs);
+        dx = si_strip_pitch() / 2.0 + (ex-sx) * copysign(1.0, xDir);
+        frac = ( test ? 1.0 : dx / dx_max);
+        eRun[exs-first] = dE*frac;   // exit strip
+    }
 
-            // scans for until it crosses the exited gap
-        }
-        else {                // entered + exited through strips
-            if ( ins == exs ) {
-                //addStrip(ins, eLoss, hit);
-                idVec.push_back(ins);
-                eVec.push_back(eLoss);
-                hitVec.push_back(hit);
-                if(eVec.size()!=idVec.size()){
-                    std::cout << eVec.size() << " " << idVec.size() << std::endl;
-                }
-            } else {
-                float sx = calculateBin(ins);
-                float dx = si_strip_pitch() / 2. - (in-sx) * copysign(1., xDir);
-                float frac = ( test ? 1.0 : dx / dx_max);
-                //addStrip(ins, dE*frac, hit); // entry strip
-                idVec.push_back(ins);
-                eVec.push_back(dE*frac);
-                hitVec.push_back(hit);
-                if(eVec.size()!=idVec.size()){
-                    std::cout << eVec.size() << " " << idVec.size() << std::endl;
-                }
-
-                sx = calculateBin(exs);
-                dx = si_strip_pitch() / 2.0 + (ex-sx) * copysign(1.0, xDir);
-                frac = ( test ? 1.0 : dx / dx_max);
-                //addStrip(exs, dE*frac, hit); // exit strip
-                idVec.push_back(exs);
-                eVec.push_back(dE*frac);
-                hitVec.push_back(hit);
-                if(eVec.size()!=idVec.size()){
-                    std::cout << eVec.size() << " " << idVec.size() << std::endl;
-                }
-
-                short sinc = (ins<exs) ? 1 : -1;
-                for ( int sid=ins+sinc; sid!=exs; sid+=sinc ) {  
-                    //addStrip(sid, dE, hit);
-                    idVec.push_back(sid);
-                    eVec.push_back(dE);
-                    hitVec.push_back(hit);
-                    if(eVec.size()!=idVec.size()){
-                        std::cout << eVec.size() << " " << idVec.size() << std::endl;
-                    }
-                }
-
-                // add energy to all strips between entry and exit
-            }   // else (ins != ens)
-        }   // else (exs != undef_strip())
-    }   // else (ins != undef_strip())
-
-
-    // now we can process all the strips
-    // for normal operation, just add the strips with the standard energy
-    // if this works, we'll add code here to do the fluctuations
-    unsigned int i;
-    unsigned int size = eVec.size();
-    if (fluctuate && size > 0 ) {
-        //unsigned int k = 0;     
-        // get the landau numbers
-        //const int nLandau = 100;
-        //double landauArray[nLandau];
-
-        //CLHEP::RandLandau::shootArray(size, landauArray);
+    // for normal operation, just add the strips with the standard energy,
+    // otherwise fluctuate, in fill order
+    int i;
+    if ( fluctuate ) {
+        if ( !rand )
+            rand = &TkrDigiVariates::global();
         float e0 = 0.0;
         float e1 = 0.0;
-        for(i=0;i<size; ++i) {
-            e0 += eVec[i];
-            double rand = CLHEP::RandLandau::shoot();
-            eVec[i] *= (1.0 + 0.095*rand);
-            e1 += eVec[i];
+        for(i=0; i<nRun; ++i) {
+            int strip;
+            if ( !bothEnds )
+                strip = start + i*step;
+            else
+                strip = i==0 ? ins : ( i==1 ? exs : ins + (i-1)*step );
+            float& e = eRun[strip-first];
+            e0 += e;
+            e *= (1.0 + 0.095*rand->landau());
+            e1 += e;
         }
         float norm = e0/e1;
-        for(i=0;i<size;++i) {
-            eVec[i] *= norm;
+        for(i=0; i<nRun; ++i) {
+            eRun[i] *= norm;
+        }
+    }
+    addStripRun(first, nRun, eRun, hit);
+}
+
+
+void SiStripList::addStripRun(const int first, const int n, const float* dE,
+                              const Event::McPositionHit* hit)
+{
+    // Purpose and Method: adds the run of strips first ... first+n-1, with
+    //                     energy dE[i] for strip first+i, and the same hit.
+    //                     If the run would take the list past the threshold
+    //                     it goes to the dense table first, where the strips
+    //                     are added without any search.
+    // Inputs: first strip id, number of strips, energies, pointer to
+    //         McPositionHit
+    // Outputs: none
+    // Dependencies: none
+    // Restrictions and Caveats: strips outside the plane are dropped
+
+    int i;
+    if ( !m_dense && m_index.size() + n >= s_denseThreshold && n > 1 )
+        makeDense();
+
+    if ( !m_dense ) {
+        for ( i=0; i<n; ++i )
+            addStrip(first+i, dE[i], hit);
+        return;
+    }
+
+    // accumulator mode
+    const int lo = std::max(first, 0);
+    const int hi = std::min(first+n, n_si_strips());
+    if ( lo >= hi )
+        return;
+    const bool noise = hit ? false : true;
+    for ( int strip=lo; strip<hi; ++strip ) {
+        const double e = dE[strip-first];
+        int pos;
+        if ( isOccupied(strip) ) {
+            pos = m_slot[strip];
+            m_energy[pos] += e;
+        }
+        else {
+            m_occupancy[strip>>5] |= 1u << (strip&31);
+            pos = appendRow(strip, e, noise, noise, -1, -1);
+            m_slot[strip] = pos;
+            if ( strip < m_lastIndex )
+                m_sorted = false;
+            m_lastIndex = strip;
         }
+        addHit(pos, hit);
+    }
+}
+
+
+int SiStripList::mergeStrips(const int n, const int* strips, const double* dE)
+{
+    // Purpose and Method: merges a sorted run of strips into the sorted
+    //                     columns.  The new strips are counted first, then
+    //                     the columns are grown and merged from the back, so
+    //                     each row moves at most once.
+    // Inputs: number of strips, strip ids in increasing order, energies
+    // Outputs: number of strips added
+    // Dependencies: none
+    // Restrictions and Caveats: strips outside the plane are dropped
+
+    compact();
+    const int size = m_index.size();
 
+    // strips already there get the energy now, the others are counted
+    int nNew = 0;
+    int i, j;
+    for ( i=0, j=0; i<n; ++i ) {
+        const int strip = strips[i];
+        if ( strip < 0 || strip >= n_si_strips() )
+            continue;
+        while ( j<size && m_index[j]<strip )
+            ++j;
+        if ( j<size && m_index[j]==strip )
+            m_energy[j] += dE[i];
+        else
+            ++nNew;
     }
-    for(i=0;i<size; ++i) {
-        addStrip(idVec[i], eVec[i], hitVec[i]);
+    if ( nNew == 0 )
+        return 0;
+
+    const int newSize = size + nNew;
+    m_index.resize(newSize);
+    m_energy.resize(newSize);
+    m_status.resize(newSize);
+    m_time1.resize(newSize);
+    m_time2.resize(newSize);
+    m_flags.resize(newSize);
+    m_hitHead.resize(newSize);
+    m_hitTail.resize(newSize);
+
+    // noise strips come with electronic noise, see findOrAddRow()
+    const unsigned char noiseFlags = NOISE | ELECNOISE;
+    int out = newSize;
+    for ( i=n-1, j=size-1; i>=0 && out>j+1; ) {
+        const int strip = strips[i];
+        if ( strip < 0 || strip >= n_si_strips() ) {
+            --i;
+            continue;
+        }
+        if ( j>=0 && m_index[j]>strip ) {
+            --out;
+            m_index[out]   = m_index[j];
+            m_energy[out]  = m_energy[j];
+            m_status[out]  = m_status[j];
+            m_time1[out]   = m_time1[j];
+            m_time2[out]   = m_time2[j];
+            m_flags[out]   = m_flags[j];
+            m_hitHead[out] = m_hitHead[j];
+            m_hitTail[out] = m_hitTail[j];
+            --j;
+            continue;
+        }
+        if ( j<0 || m_index[j]<strip ) {
+            --out;
+            m_index[out]   = strip;
+            m_energy[out]  = static_cast<float>(dE[i]);
+            m_status[out]  = GOOD;
+            m_time1[out]   = -1;
+            m_time2[out]   = -1;
+            m_flags[out]   = noiseFlags;
+            m_hitHead[out] = -1;
+            m_hitTail[out] = -1;
+        }
+        // else the strip was there, and has its energy already
+        --i;
     }
+
+    if ( m_dense ) {
+        // rows have moved, and new strips came in
+        for ( i=0; i<newSize; ++i ) {
+            const int strip = m_index[i];
+            m_occupancy[strip>>5] |= 1u << (strip&31);
+            m_slot[strip] = i;
+        }
+    }
+    else if ( static_cast<unsigned int>(newSize) >= s_denseThreshold )
+        makeDense();
+    m_lastIndex = m_index.back();
+
+    return nNew;
 }
 
+
 int SiStripList::addNoise(const double sigma, const double occupancy,
-                          const double threshold, const double trigThreshold)
+                          const double threshold, const double trigThreshold,
+                          TkrDigiVariates* rand)
 {
     // Purpose and Method: this function call other functions to add noise
-    // Inputs: noise rms in MeV, strip occupancy fraction, and energy threshold
+    // Inputs: noise rms in MeV, strip occupancy fraction, and energy threshold,
+    //         random variates (0 for the global ones)
     // Outputs: number of strips added
     // Dependencies: none
 
-    addElectronicNoise(sigma);
-    const int addedStrips   = addNoiseStrips(occupancy, threshold, trigThreshold);
-    const int removedStrips = removeStripsBelowThreshold(threshold, trigThreshold);
+    // the noise strips come with electronic noise, so they can go first
+    const int addedStrips   = addNoiseStrips(occupancy, threshold, trigThreshold,
+                                             rand);
+    const int removedStrips = addNoiseAndFlag(sigma, threshold, trigThreshold,
+                                              rand);
 
     return addedStrips - removedStrips;
 }
 
 
-void SiStripList::addElectronicNoise(const double sigma) 
+void SiStripList::addElectronicNoise(const double sigma,
+                                     TkrDigiVariates* rand) 
 {
     // Purpose and Method: checks for the elec noise flag, and adds electronic
     //                     noise to already triggered strips
-    // Inputs: noise rms in MeV
+    // Inputs: noise rms in MeV, random variates (0 for the global ones)
     // Outputs: none
     // Dependencies: none
 
-    iterator iter = begin();
-    while ( iter != end() ) {
+    if ( !rand )
+        rand = &TkrDigiVariates::global();
+    compact();
+    const int size = m_index.size();
+    for ( int i=0; i<size; ++i ) {
         // check for the electronic noise flag
-        //double eDep = iter->energy();
-        
-        //if(printEdep&&!iter->electronicNoise()) std::cout << eDep << std::endl;
-
-        if ( !(iter->electronicNoise())) {
-            iter->addEnergy(CLHEP::RandGauss::shoot(0.0, sigma));  // in MeV
-            iter->electronicNoise(true);
+        if ( (m_flags[i]&ELECNOISE) == 0 ) {
+            m_energy[i] += sigma*rand->gauss();  // in MeV
+            m_flags[i]  |= ELECNOISE;
         }
-        ++iter;
-        
     }
 }
 
 int SiStripList::addNoiseStrips(const double occupancy,
                                 const double threshold,
-                                const double /* trigThreshold */) 
+                                const double /* trigThreshold */,
+                                TkrDigiVariates* rand) 
 {
     // Purpose and Method: adds noise hits to the strip list
-    // Inputs: strip occupancy fraction, and energy threshold
+    // Inputs: strip occupancy fraction, and energy threshold,
+    //         random variates (0 for the global ones)
     // Outputs: number of strips added
     // Dependencies: none
 
     int newStrips = 0;  // counter for added strips
 
     if(occupancy>0.0) {
+        if ( !rand )
+            rand = &TkrDigiVariates::global();
         static const int N = s_stripPerWafer * s_n_si_dies;  // number of all strips
         // (random) number of strips to add
-        const int n = static_cast<int>(CLHEP::RandBinomial::shoot(N, occupancy));
+        const int n = static_cast<int>(
+            CLHEP::RandBinomial::shoot(rand->engine(), N, occupancy));
 
         for ( int i=0; i!=n; ++i ) {
             //int strip = stripId(RandFlat::shoot()*panel_width()
             //    - panel_width()/2.0);
-            int strip = static_cast<int>(CLHEP::RandFlat::shoot()*N);
-            const_iterator iter = begin();
-            for ( iter=begin(); iter!=end() && iter->index()!=strip; iter++ );
+            int strip = static_cast<int>(rand->flat()*N);
             // discard if the strip id is already in the list
-            if ( iter == end() ) {
+            if ( !hasStrip(strip) ) {
                 //TODO: use service
                 //            addStrip<Event::McPositionHit>(strip, threshold*(1.0-log(RandFlat::shoot())));
                 Event::McPositionHit* dummy;
                 dummy = 0;
 
-                double energy = threshold*(1.0-log(CLHEP::RandFlat::shoot()));
+                double energy = threshold*(1.0+rand->exponential());
                 addStrip(strip, energy, dummy);
                 //if(printEdep) std::cout << energy << std::endl;
                 ++newStrips;
@@ -464,39 +1002,92 @@ int SiStripList::removeStripsBelowThreshold(const double threshold,
 
     int removedStrips = 0;  // counter for removed strips
 
-    iterator iter = begin();
-    bool first = true;
-    while ( iter != end() ) {
-        double eDep = iter->energy();
-        //if(printEdep&&!iter->electronicNoise()&&eDep>threshold) std::cout << eDep << std::endl;
-        if ( eDep < trigThreshold) {
-            iter->setStripStatus(BELOWTRIGTHRESH);
-        }
+    compact();
+    const int size = m_index.size();
+    for ( int i=0; i<size; ++i ) {
+        const double eDep = m_energy[i];
+        const int below = eDep < threshold;
+        m_status[i] |= ( eDep < trigThreshold ? BELOWTRIGTHRESH : 0 )
+            | ( below ? BELOWDATATHRESH : 0 );
+        removedStrips += below;
+    }
 
-        if ( eDep < threshold ) {
-
-            /*
-            std::cout << "removing strip with energy " << iter->energy()
-            << " below threshold " << threshold << std::endl;
-            */
-            iter->setStripStatus(BELOWDATATHRESH);
-            if(debug) {
-                if (first) {
-                    std::cout << "Strips flagged for removal ";
-                    first = false;
-                }
-                std::cout << iter->index() << " " ;
-            }
-            ++removedStrips;
-        }
-        ++iter;
+    if ( s_printRemoved )
+        printRemoved(threshold);
+
+    return removedStrips;
+}
+
+
+int SiStripList::addNoiseAndFlag(const double sigma, const double threshold,
+                                 const double trigThreshold,
+                                 TkrDigiVariates* rand)
+{
+    // Purpose and Method: draws a gaussian for each strip without electronic
+    //                     noise, in strip order, then sweeps once over the
+    //                     columns: adds the noise, and sets the electronic
+    //                     noise flag and the threshold bits.  The sweep has
+    //                     no branches, so the compiler can vectorize it.
+    // Inputs: noise rms in MeV, data and trigger thresholds, random variates
+    //         (0 for the global ones)
+    // Outputs: number of strips below the data threshold
+    // Dependencies: none
+    // Restrictions and Caveats: same result as addElectronicNoise() followed
+    //                           by removeStripsBelowThreshold()
+
+    if ( !rand )
+        rand = &TkrDigiVariates::global();
+    compact();
+    const int size = m_index.size();
+    if ( size == 0 )
+        return 0;
+
+    float*         energy = &m_energy[0];
+    int*           status = &m_status[0];
+    unsigned char* flags  = &m_flags[0];
+
+    // strips with electronic noise already get 0
+    std::vector<double, TkrDigiArena::Allocator<double> > noise(size, 0.0);
+    int i;
+    for ( i=0; i<size; ++i )
+        if ( (flags[i]&ELECNOISE) == 0 )
+            noise[i] = sigma*rand->gauss();  // in MeV
+
+    int removedStrips = 0;
+    for ( i=0; i<size; ++i ) {
+        const float eDep = static_cast<float>(energy[i] + noise[i]);
+        const int below = eDep < threshold;
+        energy[i]  = eDep;
+        flags[i]  |= ELECNOISE;
+        status[i] |= ( eDep < trigThreshold ? BELOWTRIGTHRESH : 0 )
+            | ( below ? BELOWDATATHRESH : 0 );
+        removedStrips += below;
     }
-    if (!first) std::cout << std::endl;
+
+    if ( s_printRemoved )
+        printRemoved(threshold);
 
     return removedStrips;
 }
 
 
+void SiStripList::printRemoved(const double threshold) const
+{
+    bool first = true;
+    const int size = m_index.size();
+    for ( int i=0; i<size; ++i ) {
+        if ( m_energy[i] >= threshold )
+            continue;
+        if (first) {
+            std::cout << "Strips flagged for removal ";
+            first = false;
+        }
+        std::cout << m_index[i] << " " ;
+    }
+    if (!first) std::cout << std::endl;
+}
+
+
 // private member functions
 
 void SiStripList::getToT(int* ToT, const int tower, const int layer, const int view,
@@ -529,23 +1120,22 @@ void SiStripList::getToT(int* ToT, const int tower, const int layer, const int v
 
     int totMax    = pToTSvc->getMaxToT();
 
-    int size = m_strips.size();
+    sortIfNeeded();
+    int size = m_index.size();
     int controller = 0;
     int i;
     for (i=0; i<size; ++i ) { // loop over strips
-        const SiStripList::Strip strip = m_strips[i];
         // don't use certain kinds of bad strips
         // RC and CC overflows do contribute to the ToT
         //   but failed layers and dead strips don't (depends on how they fail??)
         //   neither do hits below the trigger threshold (tho for now, trigger and 
         //   data thresholds are the same)
 
-        int status = strip.stripStatus();
-        if ((status&NOTRIG)!=0) continue;
-        int index = strip.index();
+        if ((m_status[i]&NOTRIG)!=0) continue;
+        int index = m_index[i];
         if (index>sep) controller = 1;
-        int time1 = strip.time1();
-        int time2 = strip.time2();
+        int time1 = m_time1[i];
+        int time2 = m_time2[i];
         if( time1 != -1 && time2 != -1 ) { // strip with times ("Bari")
             if ( time1 < t1[controller] )
                 t1[controller] = time1;
@@ -553,7 +1143,7 @@ void SiStripList::getToT(int* ToT, const int tower, const int layer, const int v
                 t2[controller] = time2;
         }
         else { // strip without times ("Simple")
-            float e = strip.energy();
+            float e = m_energy[i];
             if ( e>0 ) { // "Simple" or noise
                 int iToT = pToTSvc->getRawToT(e, tower, layer, view, index);
                 simpleToT[controller] = std::max(simpleToT[controller], iToT);
@@ -578,68 +1168,160 @@ void SiStripList::getToT(int* ToT, const int tower, const int layer, const int v
     }
 }
 
+double SiStripList::insideActiveX(const HepVector3D& p)
+{
+    if ( !s_activeArea )
+        return s_detSvc->insideActiveLocalX(p);
+    if ( !s_checkActiveArea )
+        return activeX(p.x());
+    const double active = s_detSvc->insideActiveLocalX(p);
+    checkActive(active, activeX(p.x()));
+    return active;
+}
+
+
+double SiStripList::insideActiveY(const HepVector3D& p)
+{
+    if ( !s_activeArea )
+        return s_detSvc->insideActiveLocalY(p);
+    if ( !s_checkActiveArea )
+        return activeY(p.y());
+    const double active = s_detSvc->insideActiveLocalY(p);
+    checkActive(active, activeY(p.y()));
+    return active;
+}
+
+
+void SiStripList::checkActive(const double service, const double layout)
+{
+    ++s_activeChecks;
+    if ( fabs(service - layout) > 1.e-6 )
+        ++s_activeMismatches;
+}
+
+
+double SiStripList::clipSegment(HepVector3D& inVec, HepVector3D& outVec,
+                                const double activeIn, const double activeOut,
+                                const double eps)
+{
+    // Purpose and Method: moves the end of the segment that lies outside
+    //                     onto the active edge, interpolating linearly
+    //                     between the two distances.  eps pulls it a little
+    //                     further in.
+    // Inputs: entry and exit point, their distances from the active edge
+    // Outputs: fraction kept (1 if both ends are inside), -1 if both ends are
+    //          outside
+    // Dependencies: none
+
+    if (activeIn<=0 && activeOut<=0)
+        return -1.0;
+
+    const HepVector3D dir = outVec - inVec;
+    double fractionIn = 1.0;
+    double delta;
+    if (activeIn<=0) {
+        //this is more work, only one is out
+        // get the fraction in
+        delta = activeOut - activeIn; // delta is guaranteed non-zero
+        fractionIn = std::max(0.0, (activeOut - eps)/delta);
+        inVec = outVec - fractionIn*dir;
+    } else if (activeOut<=0) {
+        delta = activeIn - activeOut;
+        fractionIn = std::max(0.0, (activeIn - eps)/delta);
+        outVec = inVec + fractionIn*dir;
+    }
+    return fractionIn;
+}
+
+
 bool SiStripList::isActiveHit(HepVector3D& inVec, HepVector3D& outVec, 
                               double& eLoss, bool& trimmed) 
 {
     trimmed = false;
     bool active  = true;
-    HepVector3D dir = outVec - inVec;
     // check if the *other* projection is in the wafer
     // if partway in, we want to trim the original hit.
-    double activeYin  = s_detSvc->insideActiveLocalY(inVec);
-    double activeYout = s_detSvc->insideActiveLocalY(outVec);
+    double fractionIn = clipSegment(inVec, outVec, insideActiveY(inVec),
+        insideActiveY(outVec), 0.0);
 
     // here's the easy one
-    if (activeYin<=0 && activeYout<=0) {
+    if (fractionIn<0) {
         trimmed = true;
         return false;
     }
-
-    double fractionIn = 1.0;
-    double delta;
-    if (activeYin<=0) {
-        //this is more work, only one is out
-        // get the fraction in
-        delta = activeYout - activeYin; // delta is guaranteed non-zero
-        fractionIn = activeYout/delta;
-        inVec = outVec - fractionIn*dir;
-    } else if (activeYout<=0) {
-        delta = activeYin - activeYout;
-        fractionIn = activeYin/delta;
-        outVec = inVec + fractionIn*dir;
-    }
     if (fractionIn<1.0) trimmed = true;
     if (fractionIn<=0.0) active = false;
-    dir = outVec - inVec;
     eLoss *= fractionIn;
 
     // now for the measured projection
-    double activeXin  = s_detSvc->insideActiveLocalX(inVec);
-    double activeXout = s_detSvc->insideActiveLocalX(outVec);
+    // little fudge to make sure the point ends up inside
+    double eps  = 0.005*si_strip_pitch(); 
+    fractionIn = clipSegment(inVec, outVec, insideActiveX(inVec),
+        insideActiveX(outVec), eps);
 
-    // here's the easy one
-    if (activeXin<=0 && activeXout<=0) {
+    if (fractionIn<0) {
         trimmed = true;
         return false;
     }
-
-    fractionIn = 1.0;
-    // little fudge to make sure the point ends up inside
-    double eps  = 0.005*si_strip_pitch(); 
-    if (activeXin<=0) {
-        //this is more work, only one is out
-        // get the fraction in
-        delta = activeXout - activeXin; // delta is guaranteed nonzero!
-        fractionIn  = std::max(0.0, (activeXout - eps)/delta);
-        inVec = outVec - fractionIn*dir; 
-    } else if (activeXout<=0) {
-        delta  = activeXin - activeXout;
-        fractionIn   = std::max(0.0, (activeXin - eps)/delta);
-        outVec = inVec + fractionIn*dir;
-    }
     if (fractionIn<1.0) trimmed = true;
     if (fractionIn<=0.0) active = false;
     eLoss *= fractionIn;
 
     return active;
 }
+
+
+int SiStripList::clipToActiveArea(const int n, HepVector3D* entry,
+                                  HepVector3D* exit, double* eLoss,
+                                  int* active)
+{
+    // Purpose and Method: clips a batch of segments, as isActiveHit() does
+    //                     for a single one.  With the active area from the
+    //                     wafer layout, the distances of all segments are
+    //                     computed in one tight loop per coordinate.
+    // Inputs: number of segments, entry and exit points, energy losses
+    // Outputs: number of active segments, their indices in active
+    // Dependencies: none
+
+    int nActive = 0;
+    int i;
+    if ( !s_activeArea || s_checkActiveArea ) {
+        bool trimmed;
+        for ( i=0; i<n; ++i ) {
+            if ( isActiveHit(entry[i], exit[i], eLoss[i], trimmed) )
+                active[nActive++] = i;
+        }
+        return nActive;
+    }
+
+    std::vector<double> dIn(n), dOut(n);
+    std::vector<char>   ok(n);
+    for ( i=0; i<n; ++i ) {
+        dIn[i]  = activeY(entry[i].y());
+        dOut[i] = activeY(exit[i].y());
+    }
+    for ( i=0; i<n; ++i ) {
+        const double fractionIn =
+            clipSegment(entry[i], exit[i], dIn[i], dOut[i], 0.0);
+        ok[i] = fractionIn > 0.0;
+        if ( ok[i] )
+            eLoss[i] *= fractionIn;
+    }
+
+    const double eps = 0.005*si_strip_pitch();
+    for ( i=0; i<n; ++i ) {
+        dIn[i]  = activeX(entry[i].x());
+        dOut[i] = activeX(exit[i].x());
+    }
+    for ( i=0; i<n; ++i ) {
+        if ( !ok[i] )
+            continue;
+        const double fractionIn =
+            clipSegment(entry[i], exit[i], dIn[i], dOut[i], eps);
+        if ( fractionIn > 0.0 ) {
+            eLoss[i] *= fractionIn;
+            active[nActive++] = i;
+        }
+    }
+    return nActive;
+}
@@ -25,13 +25,18 @@
 #include "Event/MonteCarlo/McPositionHit.h"
 
 #include <algorithm>
+#include <cmath>
+#include <iterator>
 #include <vector>
 
+class TkrDigiVariates;
+
 class SiStripList {
 
 public:
 
-    SiStripList(){}
+    SiStripList() : m_hitsPacked(true), m_dense(false), m_sorted(true),
+        m_lastIndex(-1) {}
 
     ~SiStripList() { clear(); }
 
@@ -47,50 +52,45 @@ public:
     typedef std::vector<Event::McPositionHit*> hitList;
 
     // declaration of class Strip
+    /**
+    * A strip is a view of one row of the strip columns of a SiStripList.  It
+    * carries no data itself, and is valid as long as the list isn't modified
+    * by addStrip(), compact() or clear().
+    */
     class Strip {
 
     public:
 
         /**
-        * Constructor.  The strip list should contain only valid strips.  Thus,
-        * the first parameter (index) should never get a default value
-        * assigned.
-        * @param index      strip id
-        * @param energy     deposited energy
-        * @param noise      flag to label if this strip was created by noise
-        * @param hits       either a pointer to a McPositionHit or a hitList
-        * @param elecNoise  flag to label if electronic noise was added
-        * @param t1         ToT start time
-        * @param t2         ToT stop time
+        * Constructor.
+        * @param list  strip list holding the columns
+        * @param pos   row in the columns
         */
-        template<class T> Strip(const int index, const double energy=0,
-            const bool noise=false,
-            const T* hits=0, const bool elecNoise=false,
-            const int t1=-1, const int t2=-1)
-            : m_index(index), m_energy(energy), m_noise(noise),
-            m_elecNoise(elecNoise), m_stripStatus(GOOD), m_time1(t1), 
-            m_time2(t2) {
-                addHit(hits);
-            }
+        Strip(SiStripList* list=0, const int pos=0)
+            : m_list(list), m_pos(pos) {}
 
-        void energy(const double e)        { m_energy = e; }
-        void electronicNoise(const bool b) { m_elecNoise = b; }
-        void setBadStrip()                 { m_stripStatus = UNSPECIFIED; }
+        void energy(const double e)        { m_list->m_energy[m_pos] = e; }
+        void electronicNoise(const bool b) {
+            if ( b ) m_list->m_flags[m_pos] |= ELECNOISE;
+            else     m_list->m_flags[m_pos] &= ~ELECNOISE;
+        }
+        void setBadStrip()                 { m_list->m_status[m_pos] = UNSPECIFIED; }
         void setStripStatus(enum badType bad) {
-            m_stripStatus = m_stripStatus | bad ; 
+            m_list->m_status[m_pos] |= bad; 
         }
-        double energy()          const { return m_energy; }
-        int index()              const { return m_index; }
-        bool noise()             const { return m_noise; }
-        bool badStrip()          const { return (m_stripStatus!=0); }
-        int  stripStatus()       const { return m_stripStatus; }
-        bool electronicNoise()   const { return m_elecNoise; }
-        int time1()              const { return m_time1; }
-        int time2()              const { return m_time2; }
-        const hitList& getHits() const { return m_hits; }
+        double energy()          const { return m_list->m_energy[m_pos]; }
+        int index()              const { return m_list->m_index[m_pos]; }
+        bool noise()             const { return (m_list->m_flags[m_pos]&NOISE)!=0; }
+        bool badStrip()          const { return (m_list->m_status[m_pos]!=0); }
+        int  stripStatus()       const { return m_list->m_status[m_pos]; }
+        bool electronicNoise()   const { return (m_list->m_flags[m_pos]&ELECNOISE)!=0; }
+        int time1()              const { return m_list->m_time1[m_pos]; }
+        int time2()              const { return m_list->m_time2[m_pos]; }
+        /// copy of the hit list; begin() and end() avoid the copy
+        hitList getHits()        const { return hitList(begin(), end()); }
 
         /// add energy
-        void addEnergy(const double e) { m_energy += e; }
+        void addEnergy(const double e) { m_list->m_energy[m_pos] += e; }
 
         /**
         * modifies the ToT start and stop times, but only if both t1 and t2 are
@@ -98,23 +98,10 @@ public:
         * @param t1 ToT start time
         * @param t2 ToT stop time
         */
-        void addTime(const int t1, const int t2) {
-            if( ( t1 != -1 ) && ( t2 != -1 ) ) {
-                if ( t1 < m_time1 || m_time1 < 0 )
-                    m_time1 = t1;
-                if ( t2 > m_time2 )
-                    m_time2 = t2;
-            }
-        }
+        void addTime(const int t1, const int t2) { m_list->addTime(m_pos, t1, t2); }
 
         /// adding a hit to the list of hits
-        void addHit(const Event::McPositionHit* hit) {
-            if (hit!=0) {
-                hitList::iterator it=std::find(m_hits.begin(),m_hits.end(),hit);
-                if ( it == m_hits.end() )
-                    m_hits.push_back(const_cast<Event::McPositionHit*>(hit));
-            }
-        }
+        void addHit(const Event::McPositionHit* hit) { m_list->addHit(m_pos, hit); }
 
         /// adding a list of hits to the list of hits
         void addHit(const hitList* hits) {
@@ -122,9 +109,9 @@ public:
                 addHit(*it);
         }
 
-        hitList::const_iterator begin() const { return m_hits.begin(); } 
-        hitList::const_iterator end()   const { return m_hits.end(); }
-        int size() const { return m_hits.size(); }
+        hitList::const_iterator begin() const { return m_list->hitsBegin(m_pos); } 
+        hitList::const_iterator end()   const { return m_list->hitsEnd(m_pos); }
+        int size() const { return end() - begin(); }
 
         // static functions
 
@@ -133,25 +120,59 @@ public:
 
     private:
 
-        /// strip id, or undef_strip() if not set
-        int     m_index;
-        /// charge deposited
-        float   m_energy;
-        /// true if strip was generated by noise
-        bool    m_noise;
-        /// list of mc hits contributing to this strip
-        hitList m_hits;
-        /// true if energy contains contribution from electronic noise
-        bool    m_elecNoise;
-        /// true if strip is marked bad
-        int     m_stripStatus;
-        /// start ToT
-        int     m_time1;
-        /// end ToT
-        int     m_time2;
+        /// list holding the strip columns
+        SiStripList* m_list;
+        /// row in the columns
+        int          m_pos;
         };
         // end definition of class Strip
 
+        /**
+        * Iterator over the rows of a SiStripList.  Dereferencing yields a Strip
+        * view of the current row.  The view lives in the iterator, so a
+        * reference obtained from it is good until the iterator is moved.
+        * @param V     Strip or const Strip
+        * @param step  +1 for forward, -1 for reverse iteration
+        */
+        template<class V, int step> class StripIterator {
+
+        public:
+
+            typedef std::bidirectional_iterator_tag iterator_category;
+            typedef Strip value_type;
+            typedef int   difference_type;
+            typedef V*    pointer;
+            typedef V&    reference;
+
+            StripIterator(SiStripList* list=0, const int pos=0)
+                : m_list(list), m_pos(pos) {}
+            /// conversion from the non-const iterator
+            StripIterator(const StripIterator<Strip, step>& it)
+                : m_list(it.list()), m_pos(it.position()) {}
+
+            V& operator*()  const { m_view = Strip(m_list, m_pos); return m_view; }
+            V* operator->() const { return &(operator*()); }
+
+            StripIterator& operator++()   { m_pos += step; return *this; }
+            StripIterator& operator--()   { m_pos -= step; return *this; }
+            StripIterator  operator++(int) { StripIterator it(*this); m_pos += step; return it; }
+            StripIterator  operator--(int) { StripIterator it(*this); m_pos -= step; return it; }
+            StripIterator& operator+=(const int n) { m_pos += step*n; return *this; }
+
+            bool operator==(const StripIterator& it) const { return m_pos == it.m_pos; }
+            bool operator!=(const StripIterator& it) const { return m_pos != it.m_pos; }
+
+            SiStripList* list() const { return m_list; }
+            /// row the iterator points to
+            int position()      const { return m_pos; }
+
+        private:
+
+            SiStripList* m_list;
+            int          m_pos;
+            mutable Strip m_view;
+        };
+
         /**
         * Distribute energy among the various strips as the particle passes through
         * the detector.
@@ -162,6 +183,27 @@ public:
         void score(const HepPoint3D&,const HepPoint3D&,const Event::McPositionHit*, 
             bool fluctuate, bool test);
 
+    /**
+    * Adds a run of neighbouring strips, all with the same McPositionHit.
+    * @param 1   id of the first strip
+    * @param 2   number of strips
+    * @param 3   energy deposits in MeV, one per strip
+    * @param 4   pointer to a McPositionHit
+    */
+    void addStripRun(const int, const int, const float*,
+        const Event::McPositionHit*);
+
+    /**
+    * Adds strips without McPositionHit, in one merge pass over the columns.
+    * Strips already in the list get the energy added, new ones are noise,
+    * as with addStrip() and a null hit.
+    * @param 1   number of strips
+    * @param 2   strip ids, in increasing order
+    * @param 3   energy deposits in MeV, one per strip
+    * @return    number of strips added to the list
+    */
+    int mergeStrips(const int, const int*, const double*);
+
     //#define TEMPLATE
 #ifdef TEMPLATE
     /**
@@ -178,6 +220,19 @@ public:
     void addStrip(const int, const double, const hitList*, const int =-1,
         const int =-1);
 
+    /**
+    * Adds a strip with the McPositionHits of a range, e.g. of a hit vector
+    * with a different allocator.
+    * @param 1   strip id
+    * @param 2   energy deposit in MeV
+    * @param 3   first McPositionHit of the range
+    * @param 4   end of the range
+    * @param 5   ToT start time
+    * @param 6   ToT stop time
+    */
+    void addStrip(const int, const double, Event::McPositionHit* const*,
+        Event::McPositionHit* const*, const int =-1, const int =-1);
+
     /**
     * Adds a strip to the list of strips.
     * @param 1   strip id
@@ -191,7 +246,24 @@ public:
 #endif
 
 
-        void clear() { m_strips.clear(); }
+        /**
+        * Empties the list.  A list in accumulator mode falls back to the small
+        * sorted form; the strip table keeps its capacity for the next event.
+        */
+        void clear();
+
+        /**
+        * Brings the strips into index order.  In accumulator mode strips are
+        * appended as they come; this is done once, before the list is read.
+        * All iterator accessors call it, so it need not be called explicitly.
+        */
+        void compact();
+
+        /// true if a strip with this id is already in the list
+        bool hasStrip(const int strip) const;
+
+        /// true if the list works on the dense strip table
+        bool isDense() const { return m_dense; }
 
         /**
         * ToT functions.  For all functions:
@@ -210,41 +282,50 @@ public:
         *  @param s  noise rms in MeV
         *  @param o  fraction of time a cell is occupied
         *  @param t  minimium energy deposit (MeV) that results in a latch
+        *  @param rand  random variates; 0 for TkrDigiVariates::global()
         *  @return   number of strips added/removed
         */
         /// uses the following functions to manipulate the strip list
-        int  addNoise(const double s, const double o, const double t, const double trigt);
+        int  addNoise(const double s, const double o, const double t, const double trigt,
+            TkrDigiVariates* rand=0);
         /// add electronic noise to already triggered strips
-        void addElectronicNoise(const double s);
+        void addElectronicNoise(const double s, TkrDigiVariates* rand=0);
         /// add noisy strips
-        int  addNoiseStrips(const double o, const double t, const double datat);
+        int  addNoiseStrips(const double o, const double t, const double datat,
+            TkrDigiVariates* rand=0);
         /// remove strips with energy deposit below threshold
         int  removeStripsBelowThreshold(const double t, const double datat);
+        /**
+        * addElectronicNoise() and removeStripsBelowThreshold() in one sweep
+        * over the energy, flag and status columns.  The gaussians are drawn
+        * beforehand, in the same order as by addElectronicNoise().
+        * @return   number of strips below the data threshold
+        */
+        int  addNoiseAndFlag(const double s, const double t, const double trigt,
+            TkrDigiVariates* rand=0);
+        /// list the strips flagged below threshold on std::cout, for debugging
+        static void setPrintRemoved(const bool b) { s_printRemoved = b; }
 
         // typedefs to shorten typing
 
-        typedef std::vector<Strip> StripList;
-        typedef StripList::const_iterator const_iterator;
-        typedef StripList::iterator iterator;   
-        typedef StripList::const_reverse_iterator const_reverse_iterator;
-        typedef StripList::reverse_iterator reverse_iterator;
+        typedef StripIterator<Strip, 1>        iterator;
+        typedef StripIterator<const Strip, 1>  const_iterator;
+        typedef StripIterator<Strip, -1>       reverse_iterator;
+        typedef StripIterator<const Strip, -1> const_reverse_iterator;
 
-        // helpers to manipulate the StripList
+        // helpers to manipulate the strip list
 
-        int size()   const { return m_strips.size(); }
-        /// true if the StripList is empty
+        int size()   const { return m_index.size(); }
+        /// true if the strip list is empty
         bool empty() const { return size() == 0; }
-        iterator               begin()        { return m_strips.begin(); }
-        iterator               end()          { return m_strips.end(); }
-        const_iterator         begin()  const { return m_strips.begin(); } 
-        const_iterator         end()    const { return m_strips.end(); }
-        reverse_iterator       rbegin()       { return m_strips.rbegin(); }
-        reverse_iterator       rend()         { return m_strips.rend(); }
-        const_reverse_iterator rbegin() const { return m_strips.rbegin(); }
-        const_reverse_iterator rend()   const { return m_strips.rend(); }
-        iterator insert(iterator it, const Strip& x){return m_strips.insert(it, x);}
-        iterator erase(iterator it) { return m_strips.erase(it); }
-        void push_back(const Strip& x) { m_strips.push_back(x); }
+        iterator               begin()        { compact(); return iterator(this, 0); }
+        iterator               end()          { compact(); return iterator(this, size()); }
+        const_iterator         begin()  const { sortIfNeeded(); return const_iterator(self(), 0); } 
+        const_iterator         end()    const { sortIfNeeded(); return const_iterator(self(), size()); }
+        reverse_iterator       rbegin()       { compact(); return reverse_iterator(this, size()-1); }
+        reverse_iterator       rend()         { compact(); return reverse_iterator(this, -1); }
+        const_reverse_iterator rbegin() const { sortIfNeeded(); return const_reverse_iterator(self(), size()-1); }
+        const_reverse_iterator rend()   const { sortIfNeeded(); return const_reverse_iterator(self(), -1); }
 
         // static functions
 
@@ -274,21 +355,256 @@ public:
             return n_si_dies() * die_width() + ( n_si_dies() - 1 ) * ladder_gap();
         }
 
-        /// compute local coordinate from strip id
-        static const double calculateBin(int x) { return s_detSvc->stripLocalX(x); }
+        /**
+        * compute local coordinate from strip id.  Strips of the plane come
+        * from the strip-centre table, ids outside the plane (the Bari current
+        * window reaches there) from the detector service.
+        */
+        static const double calculateBin(int x) {
+            if ( s_stripTable && x>=0 && x<s_n_strips )
+                return s_stripCentre[x];
+            return s_detSvc->stripLocalX(x);
+        }
+
+        /**
+        * calculate the strip ID from the plane coordinate.  The geometry of
+        * the plane is regular: n_si_dies() ladders at a pitch of die_width()
+        * + ladder_gap(), each with a guard ring on both sides of the strips.
+        * @return  strip id, or Strip::undef_strip() in a gap or off the plane
+        */
+        static const int stripId(double x) {
+            if ( !s_stripTable )
+                return s_detSvc->stripId(x);
+            const double u = x + s_panel_half;
+            if ( u < 0 )
+                return Strip::undef_strip();
+            const int die = static_cast<int>(u / s_ladder_pitch);
+            if ( die >= s_n_si_dies )
+                return Strip::undef_strip();
+            const double xd = u - die * s_ladder_pitch - s_guard_ring;
+            if ( xd < 0 || xd >= s_active_width )
+                return Strip::undef_strip();
+            const int strip = static_cast<int>(xd / s_strip_pitch);
+            return die * s_stripPerWafer
+                + ( strip < s_stripPerWafer ? strip : s_stripPerWafer - 1 );
+        }
 
-        /// calculate the strip ID from the plane coordinate
-        static const int stripId(double x) { return s_detSvc->stripId(x); }
+        /**
+        * true if calculateBin() and stripId() use the strip geometry built by
+        * initialize().  It is false if the startup check against the detector
+        * service failed; then both go to the service.
+        */
+        static bool stripTable() { return s_stripTable; }
+
+        /**
+        * Clips a batch of segments to the active silicon, the same way
+        * score() does for a single one.  The signed distances to the active
+        * edge come from the wafer layout, see activeArea(); for each
+        * coordinate they are computed for the whole batch first.
+        * @param n       number of segments
+        * @param entry   entry points in plane coordinates, clipped in place
+        * @param exit    exit points in plane coordinates, clipped in place
+        * @param eLoss   energy losses, scaled by the fraction kept
+        * @param active  filled with the indices of the segments that hit
+        *                active silicon, in increasing order
+        * @return        number of segments that hit active silicon
+        */
+        static int clipToActiveArea(const int n, HepVector3D* entry,
+            HepVector3D* exit, double* eLoss, int* active);
+
+        /**
+        * true if the active-area distances are calculated from the wafer
+        * layout.  It is false if the startup check against the detector
+        * service failed; then the service is used.
+        */
+        static bool activeArea() { return s_activeArea; }
+
+        /**
+        * validation mode: every active-area distance is calculated both
+        * ways, and the one from the service is used.  Differences are
+        * counted.
+        */
+        static void setActiveAreaCheck(const bool b) { s_checkActiveArea = b; }
+        /// number of distances compared in validation mode
+        static long activeAreaChecks()     { return s_activeChecks; }
+        /// number of distances that differed in validation mode
+        static long activeAreaMismatches() { return s_activeMismatches; }
+
+        /**
+        * Distributes energy among the strips, for a segment already clipped
+        * to the active area (see clipToActiveArea()).
+        * @param 1   entry point in plane coordinates
+        * @param 2   exit point in plane coordinates
+        * @param 3   energy loss in the active area
+        * @param 4   pointer to a McPositionHit
+        * @param 5   do strip-wise "landau" fluctuations
+        * @param 6   test mode
+        * @param 7   variates for the fluctuations; 0 for
+        *            TkrDigiVariates::global()
+        */
+        void scoreClipped(const HepVector3D&, const HepVector3D&, double,
+            const Event::McPositionHit*, bool fluctuate, bool test,
+            TkrDigiVariates* rand=0);
 
     private:
+        friend class Strip;
+
+        /// builds the strip geometry, and checks it against the service
+        static bool buildStripTable();
+        /// derives the active area, and checks it against the service
+        static bool buildActiveArea();
+
+        /// signed distance of u from the active edge of the nearest die
+        static double insideActive(const double u, const double pitch) {
+            int die = static_cast<int>(floor(u/pitch + 0.5));
+            if ( die < 0 )
+                die = 0;
+            else if ( die >= s_n_si_dies )
+                die = s_n_si_dies - 1;
+            return s_active_half - fabs(u - die * pitch);
+        }
+        /// insideActiveLocalX() from the wafer layout
+        static double activeX(const double x) {
+            return insideActive(x + s_panel_half - 0.5*s_die_width,
+                s_ladder_pitch);
+        }
+        /// insideActiveLocalY() from the wafer layout
+        static double activeY(const double y) {
+            return insideActive(y + s_panel_half_y - 0.5*s_die_width,
+                s_ssd_pitch);
+        }
+        /// distance from the active edge in x, from wherever is configured
+        static double insideActiveX(const HepVector3D& p);
+        /// distance from the active edge in y, from wherever is configured
+        static double insideActiveY(const HepVector3D& p);
+        /// compares the two distances in validation mode
+        static void checkActive(const double service, const double layout);
+        /**
+        * clips a segment to where the distance to the active edge is
+        * positive.
+        * @return  fraction of the segment kept, or -1 if it's all outside
+        */
+        static double clipSegment(HepVector3D& inVec, HepVector3D& outVec,
+            const double activeIn, const double activeOut, const double eps);
+
+        /// bits of the flag column
+        enum stripFlag { NOISE=1, ELECNOISE=2 };
+
+        /// appends a row to the columns, and returns its position
+        int  appendRow(const int strip, const double dE, const bool noise,
+            const bool elecNoise, const int t1, const int t2);
+        /// inserts a row before position pos
+        void insertRow(const int pos, const int strip, const double dE,
+            const bool noise, const bool elecNoise, const int t1, const int t2);
+        /// finds the row of a strip, adding one if needed; -1 if out of range
+        int  findOrAddRow(const int strip, const double dE,
+            const Event::McPositionHit* hit, const int t1, const int t2);
+        /**
+        * appends a hit to the hit chain of row pos.  Duplicates are removed
+        * later, by packHits(); only a repeat of the last hit is skipped here.
+        */
+        void addHit(const int pos, const Event::McPositionHit* hit) {
+            if ( hit==0 )
+                return;
+            const int tail = m_hitTail[pos];
+            if ( tail>=0 && m_hitArena[tail]==hit )
+                return;
+            const int link = m_hitArena.size();
+            m_hitArena.push_back(const_cast<Event::McPositionHit*>(hit));
+            m_hitNext.push_back(-1);
+            if ( tail<0 )
+                m_hitHead[pos] = link;
+            else
+                m_hitNext[tail] = link;
+            m_hitTail[pos] = link;
+            m_hitsPacked = false;
+        }
+        /// makes the hits of each row contiguous and unique in the arena
+        void packHits();
+        hitList::const_iterator hitsBegin(const int pos) {
+            packHits();
+            const int head = m_hitHead[pos];
+            return m_hitArena.begin() + ( head<0 ? 0 : head );
+        }
+        hitList::const_iterator hitsEnd(const int pos) {
+            packHits();
+            const int head = m_hitHead[pos];
+            return m_hitArena.begin() + ( head<0 ? 0 : m_hitTail[pos]+1 );
+        }
+        /// see Strip::addTime()
+        void addTime(const int pos, const int t1, const int t2) {
+            if( ( t1 != -1 ) && ( t2 != -1 ) ) {
+                if ( t1 < m_time1[pos] || m_time1[pos] < 0 )
+                    m_time1[pos] = t1;
+                if ( t2 > m_time2[pos] )
+                    m_time2[pos] = t2;
+            }
+        }
+        /// the views of a const list are const, the pointer in them isn't
+        SiStripList* self() const { return const_cast<SiStripList*>(this); }
         /// method to confine hit to active area
-        bool isActiveHit(HepVector3D& inVec, HepVector3D& outVec, double& eLoss, bool& trimmed);
+        static bool isActiveHit(HepVector3D& inVec, HepVector3D& outVec, double& eLoss, bool& trimmed);
+        /// switches from the small sorted form to the dense strip table
+        void makeDense();
+        /// lists the strips below threshold, see setPrintRemoved()
+        void printRemoved(const double threshold) const;
+        /// compact() for the const accessors; the order is not part of the state
+        void sortIfNeeded() const {
+            if ( !m_sorted ) const_cast<SiStripList*>(this)->compact();
+        }
+        bool isOccupied(const int strip) const {
+            return ( m_occupancy[strip>>5] >> (strip&31) ) & 1u;
+        }
+
         /// pointer to the detector service
         static IGlastDetSvc* s_detSvc;
         // / pointer to ToT service
         //static ITkrToTSvc* s_totSvc;
-        /// vector of strips
-        StripList m_strips;        
+        // the strip columns, one row per strip, in index order unless
+        // m_sorted is false
+        /// strip id
+        std::vector<int>           m_index;
+        /// charge deposited
+        std::vector<float>         m_energy;
+        /// status bits, see badType
+        std::vector<int>           m_status;
+        /// start ToT
+        std::vector<int>           m_time1;
+        /// end ToT
+        std::vector<int>           m_time2;
+        /// noise and electronic noise flags, see stripFlag
+        std::vector<unsigned char> m_flags;
+        /// first link of the strip's hits in the hit arena, -1 if none
+        std::vector<int>           m_hitHead;
+        /// last link of the strip's hits in the hit arena
+        std::vector<int>           m_hitTail;
+
+        /**
+        * hit arena: the mc hits of all strips, chained per strip through
+        * m_hitNext.  After packHits() the hits of a strip are contiguous,
+        * from m_hitHead to m_hitTail, and free of duplicates.
+        */
+        hitList          m_hitArena;
+        /// next link of the same strip, -1 at the end of the chain
+        std::vector<int> m_hitNext;
+        /// true if the arena is packed
+        bool             m_hitsPacked;
+        /// scratch space for packHits()
+        hitList          m_hitScratch;
+        /// scratch space for score(): energies of the strips crossed
+        std::vector<float> m_runEnergy;
+        /// true if the list works on the dense strip table
+        bool m_dense;
+        /// false if strips were appended out of index order since compact()
+        bool m_sorted;
+        /// index of the strip appended last (accumulator mode only)
+        int  m_lastIndex;
+        /// row in the columns, per strip id; valid only where m_occupancy is set
+        std::vector<int>          m_slot;
+        /// one bit per strip id
+        std::vector<unsigned int> m_occupancy;
+        /// number of strips above which a list switches to the dense table
+        static const unsigned int s_denseThreshold = 32;
         /// number of silicon dies across a single layer
         static int    s_n_si_dies;       
         /// number of silicon strips across a single die
@@ -302,6 +618,39 @@ public:
         /// gap between ladders
         static double s_ladder_gap;
 
+        // strip geometry, derived from the constants above
+        /// true if the strip geometry is in use, see stripTable()
+        static bool   s_stripTable;
+        /// number of strips in a plane
+        static int    s_n_strips;
+        /// local x of each strip centre
+        static std::vector<double> s_stripCentre;
+        /// half the width of the panel
+        static double s_panel_half;
+        /// distance between the left edges of neighbouring ladders
+        static double s_ladder_pitch;
+        /// width of the strips of a die
+        static double s_active_width;
+        /// width of a single strip
+        static double s_strip_pitch;
+
+        // active area of the wafers, derived from the constants above
+        /// true if the active area is in use, see activeArea()
+        static bool   s_activeArea;
+        /// validation mode, see setActiveAreaCheck()
+        static bool   s_checkActiveArea;
+        /// see setPrintRemoved()
+        static bool   s_printRemoved;
+        /// counters for the validation mode
+        static long   s_activeChecks;
+        static long   s_activeMismatches;
+        /// half the width of the strips of a die
+        static double s_active_half;
+        /// half the length of the panel (along the ladders)
+        static double s_panel_half_y;
+        /// distance between neighbouring wafers of a ladder
+        static double s_ssd_pitch;
+
     };
 
 #endif
@@ -0,0 +1,65 @@
+/**
+ * @file SiStripListPool.cxx
+ *
+ * @brief A per-job pool of SiStripLists.
+ *
+ * $Header$
+ */
+
+#include "SiStripListPool.h"
+#include "SiStripList.h"
+
+
+SiStripListPool SiStripListPool::s_pool;
+
+
+SiStripList* SiStripListPool::get()
+{
+    // Purpose and Method: hands out a free list, or allocates a new one if
+    //                     there is none
+    // Inputs: none
+    // Outputs: an empty SiStripList
+    // Dependencies: none
+    // Restrictions and Caveats: not thread safe
+
+    std::vector<SiStripList*>& pool = s_pool.m_free;
+    if ( pool.empty() ) {
+        ++s_pool.m_allocated;
+        return new SiStripList;
+    }
+    ++s_pool.m_reused;
+    SiStripList* list = pool.back();
+    pool.pop_back();
+    return list;
+}
+
+
+void SiStripListPool::release(SiStripList* list)
+{
+    // Purpose and Method: clears a list and keeps it for get(), or deletes it
+    //                     if the pool is full
+    // Inputs: a SiStripList, which must not be used any more by the caller
+    // Outputs: none
+    // Dependencies: none
+    // Restrictions and Caveats: not thread safe
+
+    if ( !list )
+        return;
+    std::vector<SiStripList*>& pool = s_pool.m_free;
+    if ( static_cast<int>(pool.size()) >= maxFree ) {
+        delete list;
+        return;
+    }
+    list->clear();
+    pool.push_back(list);
+}
+
+
+void SiStripListPool::purge()
+{
+    std::vector<SiStripList*>& pool = s_pool.m_free;
+    for ( std::vector<SiStripList*>::iterator it=pool.begin(); it!=pool.end();
+          ++it )
+        delete *it;
+    pool.clear();
+}
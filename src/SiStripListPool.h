@@ -0,0 +1,67 @@
+/**
+ * @class SiStripListPool
+ *
+ * @brief A per-job pool of SiStripLists.
+ *
+ * The digitization creates a SiStripList for every touched plane of every
+ * event, and the SiPlaneMapContainer deletes them when the TDS is cleared.
+ * Instead, lists are taken from this pool and given back to it.  A list
+ * given back is cleared, but keeps the capacity of its strip table and hit
+ * arena, so in steady state an event needs no new allocations for its
+ * strip lists.
+ *
+ * The pool holds at most maxFree lists; lists given back beyond that are
+ * deleted.  The pooled lists are deleted at the end of the job.
+ *
+ * $Header$
+ */
+
+#ifndef __SISTRIPLISTPOOL_H__
+#define __SISTRIPLISTPOOL_H__
+
+#include "SiPlaneMap.h"
+
+#include <vector>
+
+class SiStripList;
+
+
+class SiStripListPool {
+
+ public:
+
+    /// number of free lists kept, enough for two full tracker events
+    enum { maxFree = 2 * SiPlaneMap::nPlanes };
+
+    /// returns an empty SiStripList, reused if possible
+    static SiStripList* get();
+
+    /// gives a SiStripList back to the pool; the list is cleared
+    static void release(SiStripList* list);
+
+    /// deletes the free lists
+    static void purge();
+
+    /// number of lists newly allocated
+    static long allocated() { return s_pool.m_allocated; }
+    /// number of lists handed out again
+    static long reused()    { return s_pool.m_reused; }
+    /// number of free lists
+    static int  nFree()     { return s_pool.m_free.size(); }
+
+ private:
+
+    SiStripListPool() : m_allocated(0), m_reused(0) {}
+    ~SiStripListPool() { purge(); }
+
+    /// the pool of the job
+    static SiStripListPool s_pool;
+
+    /// the free lists
+    std::vector<SiStripList*> m_free;
+    long m_allocated;
+    long m_reused;
+
+};
+
+#endif
@@ -13,6 +13,10 @@
 
 #include "../SiPlaneMapContainer.h"
 #include "../TkrVolumeIdentifier.h"
+#include "../TkrDigiArena.h"
+#include "../TkrDigiWorkerPool.h"
+#include "../TkrDigiPhilox.h"
+#include "../TkrDigiVariates.h"
 
 // Glast specific includes
 #include "Event/TopLevel/EventModel.h"
@@ -25,12 +29,105 @@
 #include "GaudiKernel/ToolFactory.h"
 #include "GaudiKernel/SmartDataPtr.h"
 
+#include "CLHEP/Random/JamesRandom.h"
+
+#include <algorithm>
+#include <vector>
+
 
 //static const ToolFactory<SimpleMcToHitTool>    s_factory;
 //const IToolFactory& SimpleMcToHitToolFactory = s_factory;
 DECLARE_TOOL_FACTORY(SimpleMcToHitTool);
 
 
+namespace {
+
+    typedef std::vector<int, TkrDigiArena::Allocator<int> > IntVector;
+
+    /**
+     * Scores the segments of one plane per item.  The segments of a plane
+     * are scored in the order of the hits, each with the engine of the
+     * worker reseeded with the seed of the segment, or, with streams, with
+     * the engine of the worker set to the stream of the plane.  Either way
+     * the variates of the worker are reset with the engine, and the result
+     * doesn't depend on which worker does which plane.
+     */
+    class PlaneScorer : public TkrDigiWorkerPool::Task {
+     public:
+        PlaneScorer(const IntVector& order, const IntVector& first,
+                    const IntVector& segs, const std::vector<long,
+                    TkrDigiArena::Allocator<long> >& seeds,
+                    const HepVector3D* entries, const HepVector3D* exits,
+                    const double* eLoss, SiStripList* const* lists,
+                    const Event::McPositionHit* const* segHits,
+                    const bool fluctuate, const bool test,
+                    const std::vector<CLHEP::HepRandomEngine*>& engines,
+                    const std::vector<TkrDigiVariates*>& variates,
+                    const bool streams, const unsigned int run,
+                    const unsigned long long event)
+            : m_order(order), m_first(first), m_segs(segs), m_seeds(seeds),
+              m_entries(entries), m_exits(exits), m_eLoss(eLoss),
+              m_lists(lists), m_segHits(segHits), m_fluctuate(fluctuate),
+              m_test(test), m_engines(engines), m_variates(variates),
+              m_streams(streams),
+              m_run(run), m_event(event) {}
+
+        void run(const int item, const int worker) {
+            const int plane = m_order[item];
+            CLHEP::HepRandomEngine* engine =
+                m_fluctuate ? m_engines[worker] : 0;
+            TkrDigiVariates* rand = m_fluctuate ? m_variates[worker] : 0;
+            if ( engine && m_streams ) {
+                static_cast<TkrDigiPhilox*>(engine)->setStream(m_run, m_event,
+                    plane, TkrDigiPhilox::LANDAU);
+                rand->reset();
+            }
+            for ( int k=m_first[plane]; k<m_first[plane+1]; ++k ) {
+                const int seg = m_segs[k];
+                if ( engine && !m_streams ) {
+                    engine->setSeed(m_seeds[k], 0);
+                    rand->reset();
+                }
+                m_lists[seg]->scoreClipped(m_entries[seg], m_exits[seg],
+                    m_eLoss[seg], m_segHits[seg], m_fluctuate, m_test,
+                    rand);
+            }
+        }
+
+     private:
+        const IntVector& m_order;
+        const IntVector& m_first;
+        const IntVector& m_segs;
+        const std::vector<long, TkrDigiArena::Allocator<long> >& m_seeds;
+        const HepVector3D* m_entries;
+        const HepVector3D* m_exits;
+        const double* m_eLoss;
+        SiStripList* const* m_lists;
+        const Event::McPositionHit* const* m_segHits;
+        const bool m_fluctuate;
+        const bool m_test;
+        const std::vector<CLHEP::HepRandomEngine*>& m_engines;
+        const std::vector<TkrDigiVariates*>& m_variates;
+        const bool m_streams;
+        const unsigned int m_run;
+        const unsigned long long m_event;
+    };
+
+    /// orders planes by decreasing work
+    class MoreWork {
+     public:
+        MoreWork(const std::vector<double, TkrDigiArena::Allocator<double> >&
+                 work) : m_work(work) {}
+        bool operator()(const int a, const int b) const {
+            return m_work[a] > m_work[b];
+        }
+     private:
+        const std::vector<double, TkrDigiArena::Allocator<double> >& m_work;
+    };
+
+}
+
+
 SimpleMcToHitTool::SimpleMcToHitTool(const std::string& type,
                                      const std::string& name,
                                      const IInterface* parent) :
@@ -42,6 +139,15 @@ SimpleMcToHitTool::SimpleMcToHitTool(const std::string& type,
     declareProperty("fluctuate", m_fluctuate = false);
     declareProperty("alignmentMode", m_alignmentMode=0);
     declareProperty("maxMCHits",m_maxMCHits=999999999);
+    declareProperty("checkActiveArea", m_checkActiveArea=false);
+    declareProperty("nThreads", m_nThreads=0);
+    declareProperty("reseedSegments", m_reseedSegments=false);
+    declareProperty("randomStreams", m_randomStreams=false);
+    declareProperty("streamSeed", m_streamSeed=0);
+
+    m_pool  = 0;
+    m_run   = 0;
+    m_event = 0;
 }
 
 StatusCode SimpleMcToHitTool::initialize() {
@@ -78,6 +184,13 @@ StatusCode SimpleMcToHitTool::initialize() {
         << " waferside "    << SiStripList::die_width() 
         << " deadgap "      << SiStripList::guard_ring() 
         << endreq;
+    if ( !SiStripList::stripTable() )
+        log << MSG::WARNING << "strip geometry disagrees with GlastDetSvc, "
+            << "taking strip positions from the service" << endreq;
+    if ( !SiStripList::activeArea() )
+        log << MSG::WARNING << "active area disagrees with GlastDetSvc, "
+            << "clipping hits with the service" << endreq;
+    SiStripList::setActiveAreaCheck(m_checkActiveArea);
 
     // Get the Tkr Geometry service 
     sc = service("TkrGeometrySvc", m_tkrGeom, true);
@@ -101,6 +214,35 @@ StatusCode SimpleMcToHitTool::initialize() {
     }
     m_edSvc = dynamic_cast<IDataProviderSvc*>(iService);
 
+    if ( m_nThreads > 0 ) {
+        m_pool = new TkrDigiWorkerPool(m_nThreads);
+        log << MSG::INFO << "scoring planes on " << m_pool->size()
+            << " threads" << endreq;
+        if ( m_pool->size() < m_nThreads )
+            log << MSG::WARNING << "could start only " << m_pool->size()
+                << " of " << m_nThreads << " threads" << endreq;
+        if ( !SiStripList::stripTable() )
+            log << MSG::WARNING << "no strip table, scoring planes in one "
+                << "thread" << endreq;
+    }
+    const int nEngines = m_pool ? m_pool->size() : 1;
+    if ( m_randomStreams ) {
+        for ( int i=0; i<nEngines; ++i )
+            m_engines.push_back(new TkrDigiPhilox(m_streamSeed));
+        log << MSG::INFO << "fluctuations from per-plane random streams, "
+            << "seed " << m_streamSeed << endreq;
+    }
+    else if ( m_pool || m_reseedSegments ) {
+        for ( int i=0; i<nEngines; ++i )
+            m_engines.push_back(new CLHEP::HepJamesRandom);
+        if ( !m_pool )
+            log << MSG::INFO << "fluctuations reseeded per segment, as with "
+                << "threads" << endreq;
+    }
+    // the variates are reset with every seed or stream, so keep them small
+    for ( unsigned int i=0; i<m_engines.size(); ++i )
+        m_variates.push_back(new TkrDigiVariates(m_engines[i], 32));
+
     return sc;
 }
 
@@ -128,6 +270,22 @@ StatusCode SimpleMcToHitTool::execute() {
         eventDir = HepVector3D(p.x(), p.y(), p.z()).unit();
     }
 
+    // the random streams are keyed by run and event
+    if ( m_randomStreams ) {
+        SmartDataPtr<Event::EventHeader> header(m_edSvc,
+                                                EventModel::EventHeader);
+        if ( header ) {
+            m_run   = header->run();
+            m_event = header->event();
+        }
+        else {
+            log << MSG::WARNING << "no event header, random streams of run 0 "
+                << "event 0" << endreq;
+            m_run   = 0;
+            m_event = 0;
+        }
+    }
+
     // Look to see if the McPositionHitCol object is in the TDS
     SmartDataPtr<Event::McPositionHitCol>
         mcHits(m_edSvc, EventModel::MC::McPositionHitCol);
@@ -166,6 +324,37 @@ StatusCode SimpleMcToHitTool::execute() {
 }
 
 
+StatusCode SimpleMcToHitTool::finalize() {
+    // Purpose and Method: reports the result of the active-area validation,
+    //                     and the use of the SiStripList pool
+    // Inputs: None
+    // Outputs: a status code
+    // Dependencies: None
+    // Restrictions and Caveats: None
+
+    MsgStream log(msgSvc(), name());
+    if ( m_checkActiveArea ) {
+        log << MSG::INFO << "active area check: "
+            << SiStripList::activeAreaMismatches() << " of "
+            << SiStripList::activeAreaChecks()
+            << " distances differ from GlastDetSvc" << endreq;
+    }
+    log << MSG::DEBUG << "SiStripList pool: " << SiStripListPool::allocated()
+        << " allocated, " << SiStripListPool::reused() << " reused"
+        << endreq;
+
+    delete m_pool;
+    m_pool = 0;
+    for ( unsigned int i=0; i<m_engines.size(); ++i ) {
+        delete m_variates[i];
+        delete m_engines[i];
+    }
+    m_variates.clear();
+    m_engines.clear();
+    return StatusCode::SUCCESS;
+}
+
+
 SiPlaneMapContainer::SiPlaneMap SimpleMcToHitTool::createSiHits(
     const Event::McPositionHitCol& hits, const HepVector3D& eventDir) {
     // Purpose and Method: reads a list of McPositionHits, and lists them in
@@ -202,6 +391,23 @@ SiPlaneMapContainer::SiPlaneMap SimpleMcToHitTool::createSiHits(
         + SiStripList::ssd_gap();
     static const double waferOffset = 0.5 * (SiStripList::n_si_dies() - 1);
 
+    // The segments, in plane coordinates.  They are clipped to the active
+    // area all at once, and then scored in the order of the hits.  They are
+    // scratch for this event, so they come from the event arena.
+    std::vector<HepVector3D, TkrDigiArena::Allocator<HepVector3D> > entries;
+    std::vector<HepVector3D, TkrDigiArena::Allocator<HepVector3D> > exits;
+    std::vector<double, TkrDigiArena::Allocator<double> >           eLoss;
+    std::vector<SiStripList*, TkrDigiArena::Allocator<SiStripList*> > lists;
+    std::vector<const Event::McPositionHit*,
+        TkrDigiArena::Allocator<const Event::McPositionHit*> >      segHits;
+    std::vector<int, TkrDigiArena::Allocator<int> >                 planes;
+    entries.reserve(nHits);
+    exits.reserve(nHits);
+    eLoss.reserve(nHits);
+    lists.reserve(nHits);
+    segHits.reserve(nHits);
+    planes.reserve(nHits);
+
     for ( Event::McPositionHitCol::const_iterator ihit=hits.begin();
           ihit!=hits.end(); ++ihit ) {
         const Event::McPositionHit* hit = *ihit;
@@ -232,9 +438,14 @@ SiPlaneMapContainer::SiPlaneMap SimpleMcToHitTool::createSiHits(
 
         m_taSvc->moveMCHit(volId, localEntry, localExit, transformAxis);
 
-        const TkrVolumeIdentifier planeId = volId.getPlaneId();
-        if( siPlaneMap.find(planeId) == siPlaneMap.end())
-            siPlaneMap[planeId]= new SiStripList;
+        const int plane = SiPlaneMap::planeIndex(volId);
+        if ( plane < 0 )
+            continue;
+        SiStripList* sList = siPlaneMap.plane(plane);
+        if ( !sList ) {
+            sList = SiStripListPool::get();
+            siPlaneMap.insert(plane, volId.getPlaneId(), sList);
+        }
 
         // now generate the plane coordinates
         // Since we know how the ladders and wafers are laid out
@@ -247,9 +458,107 @@ SiPlaneMapContainer::SiPlaneMap SimpleMcToHitTool::createSiHits(
         HepPoint3D planeEntry(localEntry + offset);
         HepPoint3D planeExit (localExit  + offset);
 
+        const double energy = ( m_test ? 0.155 : hit->depositedEnergy() );
+        if ( energy == 0 )
+            continue;
+
         // the entry into the planeMap is in plane coordinates
-        siPlaneMap[planeId]->score(planeEntry, planeExit, hit, m_fluctuate, m_test);
-          }
+        entries.push_back(planeEntry);
+        exits.push_back(planeExit);
+        eLoss.push_back(energy);
+        lists.push_back(sList);
+        segHits.push_back(hit);
+        planes.push_back(plane);
+    }
 
-          return siPlaneMap;
+    const int nSegments = eLoss.size();
+    if ( nSegments == 0 )
+        return siPlaneMap;
+
+    std::vector<int, TkrDigiArena::Allocator<int> > active(nSegments);
+    const int nActive = SiStripList::clipToActiveArea(nSegments, &entries[0],
+        &exits[0], &eLoss[0], &active[0]);
+    if ( m_pool || m_randomStreams || m_reseedSegments ) {
+        scorePlanes(nActive, &active[0], &entries[0], &exits[0], &eLoss[0],
+                    &lists[0], &planes[0], &segHits[0]);
+        return siPlaneMap;
     }
+    for ( int i=0; i<nActive; ++i ) {
+        const int seg = active[i];
+        lists[seg]->scoreClipped(entries[seg], exits[seg], eLoss[seg],
+            segHits[seg], m_fluctuate, m_test);
+    }
+
+    return siPlaneMap;
+}
+
+
+void SimpleMcToHitTool::scorePlanes(const int nActive, const int* active,
+                                    const HepVector3D* entries,
+                                    const HepVector3D* exits,
+                                    const double* eLoss,
+                                    SiStripList* const* lists,
+                                    const int* planes,
+                                    const Event::McPositionHit* const* segHits)
+{
+    // Purpose and Method: buckets the clipped segments by plane, keeping the
+    //                     order of the hits within a plane, and scores the
+    //                     planes on the worker pool, the busiest planes first.
+    //                     The seeds of the fluctuations are drawn from the
+    //                     global engine, one per segment, in the order of the
+    //                     hits, unless each plane has its random stream.
+    // Inputs: the active segments, and per segment its entry and exit point,
+    //         energy loss, SiStripList, plane number and McPositionHit
+    // Outputs: none
+    // Dependencies: m_pool (in the calling thread if 0), m_engines
+    // Restrictions and Caveats: with fluctuations on and without streams,
+    //                           the result differs from the default serial
+    //                           mode (m_nThreads=0 without m_reseedSegments),
+    //                           but doesn't depend on the number of threads.
+    //                           The streams are keyed by the run and event of
+    //                           the last execute().
+
+    const int nPlanes = SiPlaneMap::nPlanes;
+
+    // counting sort of the segments by plane number
+    IntVector first(nPlanes+1, 0);
+    int i;
+    for ( i=0; i<nActive; ++i )
+        ++first[planes[active[i]]+1];
+    for ( i=0; i<nPlanes; ++i )
+        first[i+1] += first[i];
+    IntVector fill(first.begin(), first.end()-1);
+    IntVector segs(nActive);
+    std::vector<long, TkrDigiArena::Allocator<long> > seeds(nActive);
+    std::vector<double, TkrDigiArena::Allocator<double> > work(nPlanes, 0.0);
+    const double pitch = SiStripList::si_strip_pitch();
+    for ( i=0; i<nActive; ++i ) {
+        const int seg   = active[i];
+        const int plane = planes[seg];
+        const int k = fill[plane]++;
+        segs[k] = seg;
+        if ( m_fluctuate && !m_randomStreams )
+            seeds[k] = static_cast<long>(
+                TkrDigiVariates::global().flat()*900000000.);
+        // the cost of a segment goes with the number of strips it crosses
+        work[plane] += 1.0 + fabs(exits[seg].x()-entries[seg].x()) / pitch;
+    }
+
+    IntVector order;
+    order.reserve(nPlanes);
+    for ( i=0; i<nPlanes; ++i )
+        if ( first[i+1] > first[i] )
+            order.push_back(i);
+    std::stable_sort(order.begin(), order.end(), MoreWork(work));
+
+    PlaneScorer scorer(order, first, segs, seeds, entries, exits, eLoss,
+                       lists, segHits, m_fluctuate, m_test, m_engines,
+                       m_variates, m_randomStreams, m_run, m_event);
+    // without the strip table, the strip positions come from GlastDetSvc,
+    // which isn't thread safe
+    if ( m_pool && SiStripList::stripTable() )
+        m_pool->run(scorer, order.size());
+    else
+        for ( i=0; i<static_cast<int>(order.size()); ++i )
+            scorer.run(i, 0);
+}
@@ -15,6 +15,7 @@
 #include "../IMcToHitTool.h"
 
 #include "../SiPlaneMapContainer.h"
+#include "../TkrDigiWorkerPool.h"
 
 #include "TkrUtil/ITkrGeometrySvc.h"
 #include "TkrUtil/ITkrAlignmentSvc.h"
@@ -25,6 +26,10 @@
 #include "GaudiKernel/IDataProviderSvc.h"
 
 #include <string>
+#include <vector>
+
+namespace CLHEP { class HepRandomEngine; }
+class TkrDigiVariates;
 
 
 class SimpleMcToHitTool : public AlgTool, virtual public IMcToHitTool {
@@ -37,6 +42,8 @@ class SimpleMcToHitTool : public AlgTool, virtual public IMcToHitTool {
     StatusCode initialize();
     /// Runs the tool
     StatusCode execute();
+    /// Reports the active-area validation, if turned on, and stops the threads
+    StatusCode finalize();
     /** Fills a SiPlaneMap with information based on the McPositionHitVector
      * @param a McPositionHitVector
      * @return a SiPlaneMap
@@ -63,6 +70,49 @@ class SimpleMcToHitTool : public AlgTool, virtual public IMcToHitTool {
     bool m_fluctuate;
     /// limit number of MC hits to eliminate ultra-large events.
     unsigned int m_maxMCHits;
+    /// cross-check the active-area clipping against GlastDetSvc
+    bool m_checkActiveArea;
+    /**
+     * number of threads scoring the planes.  0 scores the hits serially, in
+     * the order of the McPositionHitCol (plane by plane with
+     * m_randomStreams).  For 1 or more, the hits are bucketed by plane and
+     * the planes are scored on a worker pool; the output doesn't depend on
+     * the number of threads.  With fluctuations, the threads reseed an
+     * engine per segment, so 0 gives a different output than 1 or more,
+     * unless m_reseedSegments or m_randomStreams is set.
+     */
+    int m_nThreads;
+    /**
+     * with fluctuations and without streams, reseed them per segment also
+     * for m_nThreads=0, as the threads do, so 0, 1 and N threads give the
+     * same output.  This output differs from the default serial one.
+     */
+    bool m_reseedSegments;
+    /**
+     * draw the fluctuations of each plane from its own counter-based stream
+     * (TkrDigiPhilox), keyed by run, event and plane.  The result then
+     * doesn't depend on the number of threads, including 0, nor on the
+     * other planes of the event.
+     */
+    bool m_randomStreams;
+    /// seed selecting the set of streams, if m_randomStreams
+    int  m_streamSeed;
+    /// the workers scoring the planes, if m_nThreads>0
+    TkrDigiWorkerPool* m_pool;
+    /// one random engine per worker, for the fluctuations
+    std::vector<CLHEP::HepRandomEngine*> m_engines;
+    /// the variates of m_engines
+    std::vector<TkrDigiVariates*> m_variates;
+    /// run and event number, keying the streams
+    unsigned int       m_run;
+    unsigned long long m_event;
+
+    /// scores the clipped segments plane by plane, on m_pool if there is one
+    void scorePlanes(const int nActive, const int* active,
+                     const HepVector3D* entries, const HepVector3D* exits,
+                     const double* eLoss, SiStripList* const* lists,
+                     const int* planes,
+                     const Event::McPositionHit* const* segHits);
 };
 
 #endif
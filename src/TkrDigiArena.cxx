@@ -0,0 +1,103 @@
+/**
+ * @file TkrDigiArena.cxx
+ *
+ * @brief An event-scoped bump allocator for transient digitization data.
+ *
+ * $Header$
+ */
+
+#include "TkrDigiArena.h"
+
+
+TkrDigiArena TkrDigiArena::s_arena;
+const std::size_t TkrDigiArena::blockSize;
+
+namespace {
+    /// alignment of all allocations, enough for any fundamental type
+    const std::size_t s_align = 16;
+}
+
+
+TkrDigiArena::TkrDigiArena()
+    : m_current(0), m_used(0), m_usedBefore(0), m_resets(0),
+      m_allocations(0), m_bytes(0), m_peak(0), m_reserved(0), m_nBlocks(0)
+{}
+
+
+TkrDigiArena::~TkrDigiArena()
+{
+    release();
+}
+
+
+void* TkrDigiArena::allocate(const std::size_t n)
+{
+    // Purpose and Method: bumps the pointer of the current block.  If the
+    //                     request doesn't fit, the next block is tried, and
+    //                     if there is none, a new block is allocated.
+    // Inputs: number of bytes
+    // Outputs: pointer to the memory
+    // Dependencies: none
+    // Restrictions and Caveats: not thread safe.  Requests larger than a
+    //                           block get a block of their own.
+
+    TkrDigiArena& a = s_arena;
+    const std::size_t size = n ? ( n + s_align - 1 ) & ~( s_align - 1 )
+                               : s_align;
+    ++a.m_allocations;
+    a.m_bytes += size;
+
+    while ( a.m_current < a.m_blocks.size() ) {
+        Block& block = a.m_blocks[a.m_current];
+        if ( a.m_used + size <= block.m_size ) {
+            void* p = block.m_data + a.m_used;
+            a.m_used += size;
+            return p;
+        }
+        a.m_usedBefore += a.m_used;
+        a.m_used = 0;
+        ++a.m_current;
+    }
+
+    Block block;
+    block.m_size = size > blockSize ? size : blockSize;
+    block.m_data = new char[block.m_size];
+    a.m_blocks.push_back(block);
+    a.m_reserved += block.m_size;
+    ++a.m_nBlocks;
+    a.m_current = a.m_blocks.size() - 1;
+    a.m_used = size;
+    return block.m_data;
+}
+
+
+void TkrDigiArena::reset()
+{
+    // Purpose and Method: rewinds to the start of the first block.  The
+    //                     blocks are kept for the next event.
+    // Inputs: none
+    // Outputs: none
+    // Dependencies: none
+    // Restrictions and Caveats: all memory handed out becomes invalid
+
+    TkrDigiArena& a = s_arena;
+    const std::size_t used = a.m_usedBefore + a.m_used;
+    if ( used > a.m_peak )
+        a.m_peak = used;
+    a.m_current    = 0;
+    a.m_used       = 0;
+    a.m_usedBefore = 0;
+    ++a.m_resets;
+}
+
+
+void TkrDigiArena::release()
+{
+    reset();
+    TkrDigiArena& a = s_arena;
+    for ( std::vector<Block>::iterator it=a.m_blocks.begin();
+          it!=a.m_blocks.end(); ++it )
+        delete [] it->m_data;
+    a.m_blocks.clear();
+    a.m_reserved = 0;
+}
@@ -0,0 +1,157 @@
+/**
+ * @class TkrDigiArena
+ *
+ * @brief An event-scoped bump allocator for transient digitization data.
+ *
+ * Most of the scratch structures of the digitization (the DigiElems of the
+ * Bari chain and their hit lists, the cluster arrays, the hit vectors of the
+ * Simple tool) live for one event only.  Instead of going through malloc and
+ * free for each of them, they draw from TkrDigiArena: memory is handed out
+ * by bumping a pointer through a few large blocks, deallocation does
+ * nothing, and reset() rewinds the arena at the start of the next event.
+ * The blocks are kept, so in steady state an event does no heap allocation
+ * for these structures at all.
+ *
+ * reset() is called at the start of TkrDigiAlg::execute() and of
+ * TkrDigiMcToHitAlg::execute(), the first of the sub-algorithms, which can
+ * also be run on its own.  Everything allocated from the arena therefore
+ * has to be gone by the end of the algorithm which allocated it; nothing
+ * registered in the TDS may use it.
+ *
+ * STL containers use the arena through TkrDigiArena::Allocator, e.g.
+ *
+ *   std::vector<int, TkrDigiArena::Allocator<int> > v;
+ *
+ * Objects are created with create() and must be destroyed with destroy(),
+ * which runs the destructor but doesn't give back any memory.
+ *
+ * $Header$
+ */
+
+#ifndef __TKRDIGIARENA_H__
+#define __TKRDIGIARENA_H__
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+
+class TkrDigiArena {
+
+ public:
+
+    /**
+     * returns n bytes of memory, aligned to the largest fundamental
+     * alignment
+     */
+    static void* allocate(const std::size_t n);
+
+    /// rewinds the arena; everything allocated from it becomes invalid
+    static void reset();
+
+    /// frees the blocks of the arena; implies reset()
+    static void release();
+
+    /// creates an object in the arena
+    template<class T> static T* create() {
+        return new (allocate(sizeof(T))) T;
+    }
+    /// destroys an object created by create(); the memory isn't reused
+    template<class T> static void destroy(T* p) {
+        if ( p )
+            p->~T();
+    }
+
+    /// number of resets, i.e. events
+    static long resets()         { return s_arena.m_resets; }
+    /// number of allocations
+    static long allocations()    { return s_arena.m_allocations; }
+    /// number of bytes allocated
+    static double bytes()        { return s_arena.m_bytes; }
+    /// largest number of bytes used in one event
+    static std::size_t peak() {
+        const std::size_t used = s_arena.m_usedBefore + s_arena.m_used;
+        return used > s_arena.m_peak ? used : s_arena.m_peak;
+    }
+    /// number of bytes held in blocks
+    static std::size_t reserved() { return s_arena.m_reserved; }
+    /// number of blocks allocated from the heap
+    static long blocks()         { return s_arena.m_nBlocks; }
+
+    /**
+     * @class Allocator
+     *
+     * @brief A standard allocator drawing from the TkrDigiArena.
+     */
+    template<class T> class Allocator {
+
+     public:
+
+        typedef T              value_type;
+        typedef T*             pointer;
+        typedef const T*       const_pointer;
+        typedef T&             reference;
+        typedef const T&       const_reference;
+        typedef std::size_t    size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        template<class U> struct rebind { typedef Allocator<U> other; };
+
+        Allocator() {}
+        Allocator(const Allocator&) {}
+        template<class U> Allocator(const Allocator<U>&) {}
+        ~Allocator() {}
+
+        pointer       address(reference x)       const { return &x; }
+        const_pointer address(const_reference x) const { return &x; }
+
+        pointer allocate(const size_type n, const void* =0) {
+            return static_cast<pointer>(TkrDigiArena::allocate(n*sizeof(T)));
+        }
+        void deallocate(pointer, size_type) {}
+
+        size_type max_size() const { return size_type(-1) / sizeof(T); }
+
+        void construct(pointer p, const T& val) { new (p) T(val); }
+        void destroy(pointer p) { p->~T(); }
+
+        bool operator==(const Allocator&) const { return true; }
+        bool operator!=(const Allocator&) const { return false; }
+
+    };
+
+ private:
+
+    /// size of a regular block
+    static const std::size_t blockSize = 1 << 20;
+
+    struct Block {
+        char*       m_data;
+        std::size_t m_size;
+    };
+
+    TkrDigiArena();
+    ~TkrDigiArena();
+
+    /// the arena of the job
+    static TkrDigiArena s_arena;
+
+    /// the blocks, used in this order
+    std::vector<Block> m_blocks;
+    /// the block allocations are taken from
+    unsigned int m_current;
+    /// bytes used in the current block
+    std::size_t  m_used;
+    /// bytes used in the blocks before the current one, this event
+    std::size_t  m_usedBefore;
+
+    long         m_resets;
+    long         m_allocations;
+    double       m_bytes;
+    std::size_t  m_peak;
+    std::size_t  m_reserved;
+    long         m_nBlocks;
+
+};
+
+#endif
@@ -0,0 +1,163 @@
+/**
+ * @file TkrDigiPhilox.cxx
+ *
+ * @brief A counter-based random engine (Philox4x32-10), with one stream per
+ * run, event, plane and digitization stage.
+ *
+ * $Header$
+ */
+
+#include "TkrDigiPhilox.h"
+
+#include <fstream>
+#include <iostream>
+
+
+namespace {
+    const TkrDigiPhilox::word M0 = 0xD2511F53u;
+    const TkrDigiPhilox::word M1 = 0xCD9E8D57u;
+    const TkrDigiPhilox::word W0 = 0x9E3779B9u;
+    const TkrDigiPhilox::word W1 = 0xBB67AE85u;
+    const int nRounds = 10;
+
+    inline void mulhilo(const TkrDigiPhilox::word a,
+                        const TkrDigiPhilox::word b,
+                        TkrDigiPhilox::word& hi, TkrDigiPhilox::word& lo) {
+        const unsigned long long p = static_cast<unsigned long long>(a) * b;
+        hi = static_cast<TkrDigiPhilox::word>(p >> 32);
+        lo = static_cast<TkrDigiPhilox::word>(p);
+    }
+}
+
+
+TkrDigiPhilox::TkrDigiPhilox(const long seed)
+{
+    setSeed(seed, 0);
+}
+
+
+void TkrDigiPhilox::block(const word counter[4], const word key[2],
+                          word out[4])
+{
+    // Purpose and Method: ten Philox rounds on the counter, bumping the key
+    //                     by the Weyl constants between rounds
+    // Inputs: counter and key
+    // Outputs: four random words
+    // Dependencies: none
+    // Restrictions and Caveats: word must be 32 bits
+
+    word c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    word k0 = key[0], k1 = key[1];
+    for ( int round=0; round<nRounds; ++round ) {
+        if ( round > 0 ) {
+            k0 += W0;
+            k1 += W1;
+        }
+        word hi0, lo0, hi1, lo1;
+        mulhilo(M0, c0, hi0, lo0);
+        mulhilo(M1, c2, hi1, lo1);
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+
+void TkrDigiPhilox::setStream(const unsigned int run,
+                              const unsigned long long event,
+                              const int plane, const int stage)
+{
+    m_key[0]     = run;
+    m_counter[0] = 0;
+    m_counter[1] = static_cast<word>(event);
+    m_counter[2] = static_cast<word>(plane) << 8 | ( stage & 0xff );
+    m_counter[3] = static_cast<word>(event >> 32);
+    m_used       = 4;
+}
+
+
+void TkrDigiPhilox::flatArray(const int size, double* vect)
+{
+    for ( int i=0; i<size; ++i )
+        vect[i] = flat();
+}
+
+
+void TkrDigiPhilox::setSeed(const long seed, const int)
+{
+    theSeed  = seed;
+    m_key[1] = static_cast<word>(seed);
+    setStream(0, 0, 0, 0);
+}
+
+
+void TkrDigiPhilox::setSeeds(const long* seeds, const int n)
+{
+    // Purpose and Method: selects a stream from a list of up to 4 numbers
+    // Inputs: { run, event, plane, stage }, a 0 terminates the list if n<0
+    // Outputs: none
+    // Dependencies: none
+    // Restrictions and Caveats: missing numbers are taken as 0
+
+    long s[4] = { 0, 0, 0, 0 };
+    for ( int i=0; i<4 && ( n<0 ? seeds[i]!=0 : i<n ); ++i )
+        s[i] = seeds[i];
+    theSeeds = seeds;
+    setStream(s[0], s[1], s[2], s[3]);
+}
+
+
+void TkrDigiPhilox::saveStatus(const char filename[]) const
+{
+    std::ofstream out(filename);
+    if ( !out ) {
+        std::cerr << "TkrDigiPhilox: can't write " << filename << std::endl;
+        return;
+    }
+    out << m_key[0] << " " << m_key[1];
+    for ( int i=0; i<4; ++i )
+        out << " " << m_counter[i];
+    out << " " << m_used << std::endl;
+}
+
+
+void TkrDigiPhilox::restoreStatus(const char filename[])
+{
+    std::ifstream in(filename);
+    if ( !in ) {
+        std::cerr << "TkrDigiPhilox: can't read " << filename << std::endl;
+        return;
+    }
+    word key[2], counter[4];
+    int used;
+    in >> key[0] >> key[1] >> counter[0] >> counter[1] >> counter[2]
+       >> counter[3] >> used;
+    if ( !in || used<0 || used>4 ) {
+        std::cerr << "TkrDigiPhilox: bad status in " << filename << std::endl;
+        return;
+    }
+    m_key[0] = key[0];
+    m_key[1] = key[1];
+    for ( int i=0; i<4; ++i )
+        m_counter[i] = counter[i];
+    // the current block is the one before the counter
+    if ( used < 4 ) {
+        --m_counter[0];
+        next();
+    }
+    m_used = used;
+}
+
+
+void TkrDigiPhilox::showStatus() const
+{
+    std::cout << "TkrDigiPhilox: key " << m_key[0] << " " << m_key[1]
+              << " counter " << m_counter[0] << " " << m_counter[1] << " "
+              << m_counter[2] << " " << m_counter[3]
+              << " used " << m_used << std::endl;
+}
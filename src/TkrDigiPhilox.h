@@ -0,0 +1,97 @@
+/**
+ * @class TkrDigiPhilox
+ *
+ * @brief A counter-based random engine (Philox4x32-10), with one stream per
+ * run, event, plane and digitization stage.
+ *
+ * The global CLHEP engine set up through TkrDigiRandom hands out its numbers
+ * in the order they are asked for, so the digitization of a plane depends
+ * on everything digitized before it.  TkrDigiPhilox instead computes each
+ * block of four numbers as a function of a key and a counter:
+ *
+ *   key     = ( run, seed )
+ *   counter = ( block, event low word, plane<<8 | stage, event high word )
+ *
+ * setStream() selects the stream of a plane and stage, and restarts it.
+ * The numbers a plane gets then depend only on its stream and on the order
+ * of its own draws, so any plane of any event can be digitized again on its
+ * own, and planes can be digitized concurrently with one engine per thread,
+ * with the same result as a single thread.
+ *
+ * The engine implements CLHEP::HepRandomEngine, so it can be passed to the
+ * CLHEP distributions.  Distributions caching values between calls (e.g.
+ * RandGauss) must be used through an instance made for the stream, not
+ * through the static shoot(engine) functions, whose cache is shared with
+ * the global engine.
+ *
+ * Reference: J. K. Salmon et al., "Parallel random numbers: as easy as 1, 2,
+ * 3", SC11.
+ *
+ * $Header$
+ */
+
+#ifndef __TKRDIGIPHILOX_H__
+#define __TKRDIGIPHILOX_H__
+
+#include "CLHEP/Random/RandomEngine.h"
+
+#include <string>
+
+
+class TkrDigiPhilox : public CLHEP::HepRandomEngine {
+
+ public:
+
+    /// the digitization stages which draw random numbers
+    enum Stage { LANDAU=1, NOISE=2, NOISEBANK=3 };
+
+    typedef unsigned int word;
+
+    /// seed goes into the key; it selects a different set of streams
+    explicit TkrDigiPhilox(const long seed=0);
+    virtual ~TkrDigiPhilox() {}
+
+    /// selects and restarts the stream of a plane and stage
+    void setStream(const unsigned int run, const unsigned long long event,
+                   const int plane, const int stage);
+
+    /// the Philox4x32-10 block function
+    static void block(const word counter[4], const word key[2], word out[4]);
+
+    // HepRandomEngine interface
+
+    /// a number in ]0,1[ with 32 bit resolution
+    virtual double flat() {
+        if ( m_used == 4 )
+            next();
+        return ( m_out[m_used++] + 0.5 ) * 2.3283064365386962890625e-10;
+    }
+    virtual void flatArray(const int size, double* vect);
+    /// sets the seed (the second key word), and restarts stream 0
+    virtual void setSeed(const long seed, const int);
+    /// seeds = { run, event, plane, stage } as for setStream
+    virtual void setSeeds(const long* seeds, const int n);
+    virtual void saveStatus(const char filename[]="TkrDigiPhilox.conf") const;
+    virtual void restoreStatus(const char filename[]="TkrDigiPhilox.conf");
+    virtual void showStatus() const;
+    virtual std::string name() const { return "TkrDigiPhilox"; }
+
+ private:
+
+    /// computes the next block of the stream
+    void next() {
+        block(m_counter, m_key, m_out);
+        ++m_counter[0];
+        m_used = 0;
+    }
+
+    word m_key[2];
+    word m_counter[4];
+    /// the current block
+    word m_out[4];
+    /// numbers of the current block already used
+    int  m_used;
+
+};
+
+#endif
@@ -0,0 +1,143 @@
+/**
+ * @file TkrDigiVariates.cxx
+ *
+ * @brief Buffered random variates for the digitization: flat, gaussian,
+ * Landau and exponential.
+ *
+ * $Header$
+ */
+
+#include "TkrDigiVariates.h"
+
+#include "CLHEP/Random/Random.h"
+#include "CLHEP/Random/RandLandau.h"
+
+#include <cmath>
+
+
+TkrDigiVariates TkrDigiVariates::s_global;
+
+namespace {
+
+    /**
+     * The ziggurat of the normal density, in 128 layers of equal area
+     * (J. A. Doornik, "An improved ziggurat method to generate normal random
+     * samples", 2005).  x[i] is the right edge of layer i, r[i] the fraction
+     * of layer i under the layer above, where a point is accepted at once.
+     */
+    class Ziggurat {
+     public:
+        enum { nLayers = 128 };
+        /// start of the tail
+        static const double R;
+        /// area of a layer
+        static const double V;
+
+        Ziggurat() {
+            double f = std::exp(-0.5*R*R);
+            x[0] = V / f;
+            x[1] = R;
+            x[nLayers] = 0.0;
+            for ( int i=2; i<nLayers; ++i ) {
+                x[i] = std::sqrt(-2.0*std::log(V/x[i-1] + f));
+                f = std::exp(-0.5*x[i]*x[i]);
+            }
+            for ( int i=0; i<nLayers; ++i )
+                r[i] = x[i+1] / x[i];
+        }
+
+        double x[nLayers+1];
+        double r[nLayers];
+    };
+
+    const double Ziggurat::R = 3.442619855899;
+    const double Ziggurat::V = 9.91256303526217e-3;
+
+    const Ziggurat s_zig;
+}
+
+
+TkrDigiVariates::TkrDigiVariates(CLHEP::HepRandomEngine* engine,
+                                 const int size)
+    : m_engine(engine)
+{
+    Buffer* buffers[4] = { &m_flat, &m_gauss, &m_landau, &m_exp };
+    for ( int i=0; i<4; ++i ) {
+        buffers[i]->m_size = size>0 ? size : 1;
+        buffers[i]->m_data.resize(buffers[i]->m_size);
+        buffers[i]->m_next = buffers[i]->m_size;
+    }
+}
+
+
+CLHEP::HepRandomEngine* TkrDigiVariates::engine() const
+{
+    return m_engine ? m_engine : CLHEP::HepRandom::getTheEngine();
+}
+
+
+void TkrDigiVariates::fillFlat()
+{
+    engine()->flatArray(m_flat.m_size, &m_flat.m_data[0]);
+    m_flat.m_next = 0;
+}
+
+
+void TkrDigiVariates::fillGauss()
+{
+    for ( int i=0; i<m_gauss.m_size; ++i )
+        m_gauss.m_data[i] = ziggurat();
+    m_gauss.m_next = 0;
+}
+
+
+void TkrDigiVariates::fillLandau()
+{
+    CLHEP::RandLandau::shootArray(engine(), m_landau.m_size,
+                                  &m_landau.m_data[0]);
+    m_landau.m_next = 0;
+}
+
+
+void TkrDigiVariates::fillExponential()
+{
+    for ( int i=0; i<m_exp.m_size; ++i )
+        m_exp.m_data[i] = -std::log(flat());
+    m_exp.m_next = 0;
+}
+
+
+double TkrDigiVariates::ziggurat()
+{
+    // Purpose and Method: draws a point in a random layer of the ziggurat.
+    //                     Inside the part of the layer covered by the layer
+    //                     above, it is accepted at once (~99% of the draws).
+    //                     Otherwise it's accepted if it's under the density,
+    //                     or, in the base layer, a point of the tail is drawn.
+    // Inputs: none
+    // Outputs: a gaussian of mean 0 and rms 1
+    // Dependencies: the flat buffer
+    // Restrictions and Caveats: none
+
+    for ( ;; ) {
+        const double u = 2.0*flat() - 1.0;
+        const int i = static_cast<int>(flat()*Ziggurat::nLayers)
+            & (Ziggurat::nLayers-1);
+        if ( std::fabs(u) < s_zig.r[i] )
+            return u * s_zig.x[i];
+        if ( i == 0 ) {
+            // the tail beyond R, by Marsaglia's method
+            double x, y;
+            do {
+                x = std::log(flat()) / Ziggurat::R;
+                y = std::log(flat());
+            } while ( -2.0*y < x*x );
+            return u < 0 ? x - Ziggurat::R : Ziggurat::R - x;
+        }
+        const double x  = u * s_zig.x[i];
+        const double f0 = std::exp(-0.5*(s_zig.x[i]*s_zig.x[i] - x*x));
+        const double f1 = std::exp(-0.5*(s_zig.x[i+1]*s_zig.x[i+1] - x*x));
+        if ( f1 + flat()*(f0-f1) < 1.0 )
+            return x;
+    }
+}
@@ -0,0 +1,131 @@
+/**
+ * @class TkrDigiVariates
+ *
+ * @brief Buffered random variates for the digitization: flat, gaussian,
+ * Landau and exponential.
+ *
+ * The digitization draws most of its random numbers one at a time, in the
+ * inner loops: a gaussian per strip for the electronic noise, a Landau per
+ * strip for the fluctuations, a gaussian per charge cluster and per
+ * DigiElem in the Bari chain.  Each of these went through a static CLHEP
+ * call and the virtual engine.  TkrDigiVariates instead fills a buffer per
+ * distribution in one go, and hands out the numbers from it:
+ *
+ * - flat:        from the engine's flatArray()
+ * - gaussian:    ziggurat method (Marsaglia and Tsang), on the flat buffer
+ * - Landau:      RandLandau::shootArray(), the inverse-CDF table of CLHEP
+ * - exponential: -log of the flat buffer
+ *
+ * global() draws from the global CLHEP engine, seeded by GlastRandomSvc
+ * through TkrDigiRandom.  It is reset at the start of TkrDigiAlg::execute()
+ * and TkrDigiMcToHitAlg::execute(), after the engine has been seeded for the
+ * event, so no numbers of one event are left over to the next.  Code with an
+ * engine of its own (e.g. a TkrDigiPhilox stream) uses an instance bound to
+ * that engine, and resets it whenever it restarts or reseeds the engine.
+ *
+ * Not thread safe; each thread needs its own instance.
+ *
+ * $Header$
+ */
+
+#ifndef __TKRDIGIVARIATES_H__
+#define __TKRDIGIVARIATES_H__
+
+#include <vector>
+
+namespace CLHEP { class HepRandomEngine; }
+
+
+class TkrDigiVariates {
+
+ public:
+
+    /**
+     * @param engine  the engine to draw from; 0 for the global CLHEP engine,
+     *                taken at each refill
+     * @param size    number of variates per refill of a buffer
+     */
+    explicit TkrDigiVariates(CLHEP::HepRandomEngine* engine=0,
+                             const int size=256);
+
+    /// the instance drawing from the global engine
+    static TkrDigiVariates& global() { return s_global; }
+
+    /// drops all buffered numbers, e.g. after the engine has been reseeded
+    void reset() {
+        m_flat.m_next   = m_flat.m_size;
+        m_gauss.m_next  = m_gauss.m_size;
+        m_landau.m_next = m_landau.m_size;
+        m_exp.m_next    = m_exp.m_size;
+    }
+    /// the engine drawn from, for distributions without a buffer
+    CLHEP::HepRandomEngine* engine() const;
+    /// draws from another engine; implies reset()
+    void setEngine(CLHEP::HepRandomEngine* engine) {
+        m_engine = engine;
+        reset();
+    }
+
+    /// flat in ]0,1[
+    double flat() {
+        if ( m_flat.empty() )
+            fillFlat();
+        return m_flat.next();
+    }
+    /// flat in [a,b[
+    double flat(const double a, const double b) { return a + (b-a)*flat(); }
+    /// gaussian of mean 0 and rms 1
+    double gauss() {
+        if ( m_gauss.empty() )
+            fillGauss();
+        return m_gauss.next();
+    }
+    double gauss(const double mean, const double sigma) {
+        return mean + sigma*gauss();
+    }
+    /// Landau, as RandLandau::shoot()
+    double landau() {
+        if ( m_landau.empty() )
+            fillLandau();
+        return m_landau.next();
+    }
+    /// exponential of mean 1
+    double exponential() {
+        if ( m_exp.empty() )
+            fillExponential();
+        return m_exp.next();
+    }
+
+ private:
+
+    TkrDigiVariates(const TkrDigiVariates&);
+    TkrDigiVariates& operator=(const TkrDigiVariates&);
+
+    /// a buffer of variates, handed out from the front
+    struct Buffer {
+        std::vector<double> m_data;
+        int m_size;
+        int m_next;
+        bool   empty() const { return m_next == m_size; }
+        double next()        { return m_data[m_next++]; }
+    };
+
+    void fillFlat();
+    void fillGauss();
+    void fillLandau();
+    void fillExponential();
+    /// one gaussian by the ziggurat method
+    double ziggurat();
+
+    /// the instance of the global engine
+    static TkrDigiVariates s_global;
+
+    CLHEP::HepRandomEngine* m_engine;
+    Buffer m_flat;
+    Buffer m_gauss;
+    Buffer m_landau;
+    Buffer m_exp;
+
+};
+
+#endif
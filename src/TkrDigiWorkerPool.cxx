@@ -0,0 +1,154 @@
+/**
+ * @file TkrDigiWorkerPool.cxx
+ *
+ * @brief A small pool of worker threads for independent work items.
+ *
+ * $Header$
+ */
+
+#include "TkrDigiWorkerPool.h"
+
+
+TkrDigiWorkerPool::TkrDigiWorkerPool(const int size)
+    : m_size(size>1 ? size : 1), m_task(0), m_nItems(0), m_next(0)
+{
+    // Purpose and Method: starts the threads, which wait for a task
+    // Inputs: number of workers
+    // Outputs: none
+    // Dependencies: pthreads
+    // Restrictions and Caveats: if a thread can't be started, the pool
+    //                           shrinks to the threads which did start
+
+#ifdef TKRDIGI_PTHREADS
+    m_generation = 0;
+    m_busy = 0;
+    m_stop = false;
+    pthread_mutex_init(&m_mutex, 0);
+    pthread_cond_init(&m_start, 0);
+    pthread_cond_init(&m_done, 0);
+    // the Thread structs must not move once the threads have started
+    m_threads.resize(m_size-1);
+    int started = 0;
+    for ( ; started<m_size-1; ++started ) {
+        Thread& t = m_threads[started];
+        t.m_pool   = this;
+        t.m_worker = started + 1;
+        if ( pthread_create(&t.m_id, 0, threadMain, &t) != 0 )
+            break;
+    }
+    m_threads.resize(started);
+    m_size = started + 1;
+#else
+    m_size = 1;
+#endif
+}
+
+
+TkrDigiWorkerPool::~TkrDigiWorkerPool()
+{
+#ifdef TKRDIGI_PTHREADS
+    pthread_mutex_lock(&m_mutex);
+    m_stop = true;
+    pthread_cond_broadcast(&m_start);
+    pthread_mutex_unlock(&m_mutex);
+    for ( std::vector<Thread>::iterator it=m_threads.begin();
+          it!=m_threads.end(); ++it )
+        pthread_join(it->m_id, 0);
+    pthread_cond_destroy(&m_done);
+    pthread_cond_destroy(&m_start);
+    pthread_mutex_destroy(&m_mutex);
+#endif
+}
+
+
+void TkrDigiWorkerPool::run(Task& task, const int nItems)
+{
+    // Purpose and Method: wakes the threads for a new task, works on it in
+    //                     the calling thread, and waits for the others
+    // Inputs: the task and its number of items
+    // Outputs: none
+    // Dependencies: none
+    // Restrictions and Caveats: must not be called from within a task
+
+    m_task   = &task;
+    m_nItems = nItems;
+    m_next   = 0;
+
+#ifdef TKRDIGI_PTHREADS
+    if ( m_size > 1 && nItems > 1 ) {
+        pthread_mutex_lock(&m_mutex);
+        m_busy = m_threads.size();
+        ++m_generation;
+        pthread_cond_broadcast(&m_start);
+        pthread_mutex_unlock(&m_mutex);
+
+        work(0);
+
+        pthread_mutex_lock(&m_mutex);
+        while ( m_busy > 0 )
+            pthread_cond_wait(&m_done, &m_mutex);
+        pthread_mutex_unlock(&m_mutex);
+        m_task = 0;
+        return;
+    }
+#endif
+
+    for ( int item=0; item<nItems; ++item )
+        task.run(item, 0);
+    m_task = 0;
+}
+
+
+void TkrDigiWorkerPool::work(const int worker)
+{
+    for ( ;; ) {
+#ifdef TKRDIGI_PTHREADS
+        pthread_mutex_lock(&m_mutex);
+        const int item = m_next++;
+        pthread_mutex_unlock(&m_mutex);
+#else
+        const int item = m_next++;
+#endif
+        if ( item >= m_nItems )
+            return;
+        m_task->run(item, worker);
+    }
+}
+
+
+#ifdef TKRDIGI_PTHREADS
+void* TkrDigiWorkerPool::threadMain(void* arg)
+{
+    Thread* t = static_cast<Thread*>(arg);
+    t->m_pool->loop(t->m_worker);
+    return 0;
+}
+
+
+void TkrDigiWorkerPool::loop(const int worker)
+{
+    // Purpose and Method: waits for a task, works on it, and reports back
+    // Inputs: number of the worker
+    // Outputs: none
+    // Dependencies: none
+    // Restrictions and Caveats: returns when the pool is destroyed
+
+    long seen = 0;
+    pthread_mutex_lock(&m_mutex);
+    for ( ;; ) {
+        while ( !m_stop && m_generation == seen )
+            pthread_cond_wait(&m_start, &m_mutex);
+        if ( m_stop )
+            break;
+        seen = m_generation;
+        pthread_mutex_unlock(&m_mutex);
+
+        work(worker);
+
+        pthread_mutex_lock(&m_mutex);
+        if ( --m_busy == 0 )
+            pthread_cond_signal(&m_done);
+    }
+    pthread_mutex_unlock(&m_mutex);
+}
+#endif
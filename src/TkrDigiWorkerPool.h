@@ -0,0 +1,97 @@
+/**
+ * @class TkrDigiWorkerPool
+ *
+ * @brief A small pool of worker threads for independent work items.
+ *
+ * run() hands the items 0 ... n-1 of a task to the workers, the calling
+ * thread being one of them.  Each worker takes the next free item when it
+ * is done with its last one, so workers which drew cheap items go on to
+ * take over the rest of the work.  Callers order the items by decreasing
+ * cost for the best balance.  run() returns when all items are done.
+ *
+ * The threads are started once and wait between tasks.  Without pthreads
+ * (i.e. on Windows), and for a pool of size 1, the calling thread does all
+ * items itself, in order.
+ *
+ * $Header$
+ */
+
+#ifndef __TKRDIGIWORKERPOOL_H__
+#define __TKRDIGIWORKERPOOL_H__
+
+#ifndef _WIN32
+#define TKRDIGI_PTHREADS
+#include <pthread.h>
+#endif
+
+#include <vector>
+
+
+class TkrDigiWorkerPool {
+
+ public:
+
+    /**
+     * @class Task
+     *
+     * @brief A set of work items.  run() must be safe to call concurrently
+     * for different items.
+     */
+    class Task {
+     public:
+        virtual ~Task() {}
+        /**
+         * does one item
+         * @param item    item number
+         * @param worker  number of the worker, 0 ... size()-1
+         */
+        virtual void run(const int item, const int worker) = 0;
+    };
+
+    /// starts size-1 threads; the calling thread is the size'th worker
+    explicit TkrDigiWorkerPool(const int size);
+    /// stops and joins the threads
+    ~TkrDigiWorkerPool();
+
+    /// number of workers, including the calling thread
+    int size() const { return m_size; }
+
+    /// does the items 0 ... nItems-1 of task, and returns when all are done
+    void run(Task& task, const int nItems);
+
+ private:
+
+    TkrDigiWorkerPool(const TkrDigiWorkerPool&);
+    TkrDigiWorkerPool& operator=(const TkrDigiWorkerPool&);
+
+    /// takes items until there are none left
+    void work(const int worker);
+
+    int   m_size;
+    Task* m_task;
+    int   m_nItems;
+    int   m_next;
+
+#ifdef TKRDIGI_PTHREADS
+    struct Thread {
+        TkrDigiWorkerPool* m_pool;
+        int                m_worker;
+        pthread_t          m_id;
+    };
+    static void* threadMain(void* arg);
+    void loop(const int worker);
+
+    std::vector<Thread> m_threads;
+    pthread_mutex_t m_mutex;
+    pthread_cond_t  m_start;
+    pthread_cond_t  m_done;
+    /// counts the tasks, so waiting threads know a new one has come
+    long m_generation;
+    /// number of threads still working on the current task
+    int  m_busy;
+    bool m_stop;
+#endif
+
+};
+
+#endif
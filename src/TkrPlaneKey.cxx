@@ -0,0 +1,54 @@
+/**
+ * @file TkrPlaneKey.cxx
+ *
+ * @brief A tracker plane packed into 16 bits.
+ *
+ * $Header$
+ */
+
+#include "TkrPlaneKey.h"
+#include "TkrVolumeIdentifier.h"
+
+
+TkrPlaneKey::TkrPlaneKey(const idents::VolumeIdentifier& id)
+    : m_key(invalidKey) {
+    // Purpose and Method: decodes the plane fields of a volume identifier
+    // Inputs: a volume identifier of a plane, or of a wafer in a plane
+    // Outputs: none
+    // Dependecies: none
+    // Restrictions and Caveats: the key stays invalid if id isn't in the
+    //                           tracker, or a field doesn't fit into the key
+
+    const TkrVolumeIdentifier volId = id;
+    if ( volId.size() < 7 || !volId.isTowerTkr() )
+        return;
+    const int tower  = volId.getTower().id();
+    const int tray   = volId.getTray();
+    const int view   = volId.getView();
+    const int botTop = volId.getBotTop();
+    if ( tower<0 || tower>towerMask || tray<0 || tray>trayMask
+         || view<0 || view>viewMask || botTop<0 || botTop>botTopMask )
+        return;
+    m_key = encode(tower, tray, view, botTop);
+}
+
+
+idents::VolumeIdentifier TkrPlaneKey::volumeId() const {
+    // Purpose and Method: builds the truncated volume identifier of the plane.
+    //                     Ladder and wafer information are not filled.
+    // Inputs: none
+    // Outputs: an idents::VolumeIdentifier
+    // Dependecies: none
+    // Restrictions and Caveats: the key must be valid
+
+    idents::VolumeIdentifier id;
+    id.append(0);  // LAT: 0
+    const idents::TowerId towerId(tower());
+    id.append(towerId.iy());
+    id.append(towerId.ix());
+    id.append(1);  // TKR: 1
+    id.append(tray());
+    id.append(view());
+    id.append(botTop());
+    return id;
+}
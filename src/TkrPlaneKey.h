@@ -0,0 +1,122 @@
+/**
+ * @class TkrPlaneKey
+ *
+ * @brief A tracker plane packed into 16 bits.
+ *
+ * Decoding tower, bilayer and view from a TkrVolumeIdentifier goes through
+ * idents::VolumeIdentifier::operator[] for each field, and for the tower
+ * through an idents::TowerId.  Code which needs these for every plane should
+ * decode the volume identifier once into a TkrPlaneKey and carry the key.
+ *
+ * The key is laid out as
+ *
+ *   bit  0      botTop
+ *   bit  1      view
+ *   bits 2-6    tray
+ *   bits 7-10   tower (idents::TowerId::id())
+ *
+ * so that ordering keys is ordering the volume identifiers of the planes.
+ * All encode/decode functions are inline and static versions work on the
+ * raw key, so they can be used in loops over plain arrays of keys.
+ *
+ * $Header$
+ */
+
+#ifndef __TKRPLANEKEY_H__
+#define __TKRPLANEKEY_H__
+
+#include "idents/GlastAxis.h"
+#include "idents/TowerId.h"
+#include "idents/VolumeIdentifier.h"
+
+
+class TkrPlaneKey {
+
+ public:
+
+    typedef unsigned short key_type;
+
+    enum { botTopShift=0, viewShift=1, trayShift=2, towerShift=7,
+           botTopMask=0x1, viewMask=0x1, trayMask=0x1f, towerMask=0xf,
+           invalidKey=0xffff };
+
+    /// an invalid key
+    TkrPlaneKey() : m_key(invalidKey) {}
+    /// wraps a raw key
+    explicit TkrPlaneKey(const key_type key) : m_key(key) {}
+    /// from tower id, tray, view and botTop
+    TkrPlaneKey(const int tower, const int tray, const int view,
+                const int botTop) : m_key(encode(tower, tray, view, botTop)) {}
+    /**
+     * Decodes a volume identifier of a plane, or of a wafer in a plane.  The
+     * key is invalid if id isn't in the tracker.
+     */
+    explicit TkrPlaneKey(const idents::VolumeIdentifier& id);
+
+    /// from tower id, biLayer number and view
+    static TkrPlaneKey fromLayer(const int tower, const int layer,
+                                 const int view) {
+        return TkrPlaneKey(encodeLayer(tower, layer, view));
+    }
+
+    static key_type encode(const int tower, const int tray, const int view,
+                           const int botTop) {
+        return static_cast<key_type>( tower << towerShift | tray << trayShift
+                                      | view << viewShift
+                                      | botTop << botTopShift );
+    }
+    static key_type encodeLayer(const int tower, const int layer,
+                                const int view) {
+        int tray, botTop;
+        layerToTray(layer, view, tray, botTop);
+        return encode(tower, tray, view, botTop);
+    }
+
+    /// makes up the tray and botTop from bilayer and view
+    static void layerToTray(const int layer, const int view, int& tray,
+                            int& botTop) {
+        if ( layer%2 == 0 ) {
+            tray = layer + 1 - view;
+            botTop = view;
+        }
+        else {
+            tray = layer + view;
+            botTop = 1 - view;
+        }
+    }
+
+    static int tower (const key_type k) { return k>>towerShift & towerMask; }
+    static int tray  (const key_type k) { return k>>trayShift & trayMask; }
+    static int view  (const key_type k) { return k>>viewShift & viewMask; }
+    static int botTop(const key_type k) { return k>>botTopShift & botTopMask;}
+    static int layer (const key_type k) { return tray(k) - 1 + botTop(k); }
+
+    key_type key()  const { return m_key; }
+    bool isValid()  const { return m_key != invalidKey; }
+
+    int tower()     const { return tower(m_key); }
+    int tray()      const { return tray(m_key); }
+    int view()      const { return view(m_key); }
+    int botTop()    const { return botTop(m_key); }
+    int layer()     const { return layer(m_key); }
+
+    idents::TowerId towerId() const { return idents::TowerId(tower()); }
+    /// Returns the view as a GlastAxis::axis.  Some functions require this.
+    idents::GlastAxis::axis axis() const {
+        return view()==0 ? idents::GlastAxis::X : idents::GlastAxis::Y;
+    }
+
+    /// the (truncated) volume identifier of the plane
+    idents::VolumeIdentifier volumeId() const;
+
+    bool operator==(const TkrPlaneKey& k) const { return m_key == k.m_key; }
+    bool operator!=(const TkrPlaneKey& k) const { return m_key != k.m_key; }
+    bool operator< (const TkrPlaneKey& k) const { return m_key <  k.m_key; }
+
+ private:
+
+    key_type m_key;
+
+};
+
+#endif
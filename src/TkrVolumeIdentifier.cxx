@@ -37,14 +37,7 @@ TkrVolumeIdentifier::TkrVolumeIdentifier(const int& tower, const int& layer,
     append(1);  // TKR: 1
     int tray, botTop;
     // make up the tray and botTop from bilayer and view
-    if ( layer%2 == 0 ) {
-        tray = layer + 1 - view;
-        botTop = view;
-    }
-    else {
-        tray = layer + view;
-        botTop = 1 - view;
-    }
+    TkrPlaneKey::layerToTray(layer, view, tray, botTop);
     append(tray);
     append(view);
     append(botTop);
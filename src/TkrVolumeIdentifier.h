@@ -21,6 +21,8 @@
 #include "idents/VolumeIdentifier.h"
 #include "idents/TowerId.h"
 
+#include "TkrPlaneKey.h"
+
 
 class TkrVolumeIdentifier : public idents::VolumeIdentifier {
 
@@ -44,6 +46,12 @@ class TkrVolumeIdentifier : public idents::VolumeIdentifier {
      */
     TkrVolumeIdentifier(const int& tower, const int& layer, const int& view);
 
+    /// Constructs the truncated volume identifier of a plane key.
+    TkrVolumeIdentifier(const TkrPlaneKey& key) : idents::VolumeIdentifier() {
+        const idents::VolumeIdentifier id = key.volumeId();
+        init(id.getValue(), id.size());
+    }
+
     /**
      * Assigns an idents::VolumeIdentifier to a TkrVolumeIdentifier.
      */
@@ -84,6 +92,13 @@ class TkrVolumeIdentifier : public idents::VolumeIdentifier {
      */
     idents::VolumeIdentifier getPlaneId() const;
 
+    /**
+     * Returns the plane packed into a TkrPlaneKey, to be used instead of
+     * repeated calls of the get methods.  The key is invalid if the element
+     * isn't in "TowerTKR".
+     */
+    TkrPlaneKey getPlaneKey() const { return TkrPlaneKey(*this); }
+
     /// Returns true if the element is in "LATTowers" (1).
     bool isLatTowers() const { return getLatObject() == 0; }
 
@@ -0,0 +1,299 @@
+// $Header$
+
+// Include files
+// Gaudi system includes
+#include "GaudiKernel/MsgStream.h"
+#include "GaudiKernel/AlgFactory.h"
+#include "GaudiKernel/Algorithm.h"
+
+#include "GlastSvc/GlastDetSvc/IGlastDetSvc.h"
+#include "facilities/Util.h"
+
+#include "CLHEP/Random/Random.h"
+#include "CLHEP/Random/JamesRandom.h"
+#include "CLHEP/Units/PhysicalConstants.h"
+
+#include "../Bari/ClusterPropagator.h"
+#include "../Bari/CurrOr.h"
+#include "../Bari/InitCurrent.h"
+#include "../SiStripList.h"
+#include "../TkrDigiArena.h"
+#include "../TkrDigiVariates.h"
+#include "../TkrPlaneKey.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+// Define the class here instead of in a header file: not needed anywhere but here!
+//------------------------------------------------------------------------------
+/**
+Compares the block kernel of ClusterPropagator with the scalar propagation
+it replaced, cluster by cluster with the diffusion redrawn until it lands on
+the silicon.  The two draw their random numbers in a different order, so
+the comparison is statistical: the current collected on each strip around
+the clusters, summed over many blocks, must agree within maxPull standard
+deviations, and so must the total current.  Half of the blocks start at the
+edge of a die, where the diffusion often leaves the silicon.
+
+The check runs at initialize, with its own random engines seeded by the
+job options, so it is reproducible and doesn't change the events.
+*/
+class test_BariPropagator : public Algorithm {
+public:
+    test_BariPropagator(const std::string& name, ISvcLocator* pSvcLocator);
+    StatusCode initialize();
+    StatusCode execute();
+    StatusCode finalize();
+
+private:
+    /// current collected by strip offset from the first cluster, per block
+    void propagate(const bool scalar, const int nClusters, const double* x,
+                   const double* z, const double* q, const int refStrip,
+                   std::vector<double>& profile);
+
+    /// file of the currents, as for BariMcToHitTool
+    std::string m_currentsFile;
+    /// seed of the clusters and of the propagation
+    int         m_seed;
+    /// number of blocks of clusters propagated by each path
+    int         m_nBlocks;
+    /// largest pull allowed between the two paths
+    double      m_maxPull;
+
+    InitCurrent m_openCurr;
+};
+//------------------------------------------------------------------------
+
+DECLARE_ALGORITHM_FACTORY(test_BariPropagator);
+
+namespace {
+    /// strips on each side of the first cluster in the profile
+    const int nSide = 30;
+
+    /// the propagation as it was before the block kernel, with the angle in
+    /// radians
+    void scalarPropagate(InitCurrent* current, CurrOr* mapCurr,
+                         const double* XClus, const double* ZClus,
+                         const double* QClus, const int NClus,
+                         const idents::VolumeIdentifier& volId)
+    {
+        const double ZZ0 = -0.2;
+        const int perDie = SiStripList::strips_per_die();
+        TkrDigiVariates& rand = TkrDigiVariates::global();
+        Event::McPositionHit* pHit = 0;
+        for ( int j=0; j<NClus; ++j ) {
+            const unsigned int id1 = SiStripList::stripId(XClus[j]);
+            if ( id1 == 65535 )
+                continue;
+            double XV[2] = { XClus[j] - SiStripList::calculateBin(id1),
+                             ZClus[j] - ZZ0 };
+            current->GetCharge(XV);
+            const double sigma[2] = { current->GetCh()[5]*10.*rand.gauss(),
+                                      current->GetCh()[11]*10.*rand.gauss() };
+            for ( int carrier=0; carrier<2; ++carrier ) {
+                double phi, x;
+                unsigned int id;
+                do {
+                    phi = rand.flat(0., CLHEP::twopi);
+                    x   = XClus[j] + std::cos(phi)*sigma[carrier];
+                    id  = SiStripList::stripId(x);
+                } while ( id == 65535 );
+                XV[0] = x - SiStripList::calculateBin(id);
+                XV[1] = ZClus[j] + std::sin(phi)*sigma[carrier] - ZZ0;
+                current->GetCharge(XV);
+                const int die = static_cast<int>(id)/perDie;
+                for ( int jj=0; jj<5; ++jj ) {
+                    const int strip = id - 2 + jj;
+                    if ( strip/perDie != die )
+                        continue;
+                    const double I = current->GetCh()[jj+6*carrier]*QClus[j];
+                    mapCurr->add(volId, strip, &I, pHit);
+                }
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+//! ctor
+test_BariPropagator::test_BariPropagator(const std::string& name,
+                                         ISvcLocator* pSvcLocator)
+:Algorithm(name, pSvcLocator)
+{
+    declareProperty("CurrentsFile",
+                    m_currentsFile="$(TKRDIGIDATAPATH)/Bari_charge.txt");
+    declareProperty("seed",    m_seed=1234);
+    declareProperty("nBlocks", m_nBlocks=4000);
+    declareProperty("maxPull", m_maxPull=4.0);
+}
+
+//------------------------------------------------------------------------
+//! runs the comparison
+StatusCode test_BariPropagator::initialize(){
+    // Purpose and Method: propagates the same blocks of clusters along both
+    //                     paths, each with its own engine, and compares the
+    //                     sums of the current profiles, bin by bin, with the
+    //                     spread of the profiles over the blocks
+    // Inputs: None
+    // Outputs: a status code, FAILURE if the paths disagree
+    // Dependencies: GlastDetSvc, the currents file
+    // Restrictions and Caveats: the global CLHEP engine is replaced during
+    //                           the comparison, and restored after it
+
+    StatusCode  sc = StatusCode::SUCCESS;
+    MsgStream log(msgSvc(), name());
+    log << MSG::INFO << "initialize" << endreq;
+    setProperties();
+
+    IGlastDetSvc* detSvc = 0;
+    sc = service("GlastDetSvc", detSvc);
+    if ( sc.isFailure() || SiStripList::initialize(detSvc).isFailure() ) {
+        log << MSG::ERROR << "Couldn't set up the strip geometry" << endreq;
+        return StatusCode::FAILURE;
+    }
+    facilities::Util::expandEnvVar(&m_currentsFile);
+    sc = m_openCurr.OpenCurrent(m_currentsFile);
+    if ( sc.isFailure() ) {
+        log << MSG::ERROR << "currents file " << m_currentsFile
+            << " not found" << endreq;
+        return sc;
+    }
+
+    CLHEP::HepRandomEngine* const saved = CLHEP::HepRandom::getTheEngine();
+    CLHEP::HepJamesRandom clusterEngine(m_seed);
+    CLHEP::HepJamesRandom propagateEngine;
+    CLHEP::HepRandom::setTheEngine(&propagateEngine);
+
+    const int nBins = 2*nSide + 1;
+    const int nDies = SiStripList::n_si_dies();
+    const double ladderPitch = SiStripList::die_width()
+        + SiStripList::ladder_gap();
+    const double activeWidth = SiStripList::die_width()
+        - 2.0*SiStripList::guard_ring();
+    // sum and sum of squares of the profiles, per path; the last bin is the
+    // total current
+    std::vector<double> sum[2], sum2[2];
+    for ( int path=0; path<2; ++path ) {
+        sum[path].assign(nBins+1, 0.0);
+        sum2[path].assign(nBins+1, 0.0);
+    }
+    std::vector<double> x, z, q, profile;
+    for ( int block=0; block<m_nBlocks; ++block ) {
+        // a straight track of clusters, in the middle of the plane or from
+        // the edge of a die inwards
+        const int nClusters = 1 + static_cast<int>(clusterEngine.flat()*150);
+        const int die = static_cast<int>(clusterEngine.flat()*nDies);
+        const double lo = -0.5*SiStripList::panel_width() + die*ladderPitch
+            + SiStripList::guard_ring();
+        double x0, step;
+        if ( block%2 ) {
+            x0   = lo + clusterEngine.flat()*activeWidth;
+            step = 0.01;
+        } else {
+            const bool high = clusterEngine.flat() < 0.5;
+            const double inside = 0.05*clusterEngine.flat();
+            x0   = high ? lo + activeWidth - inside : lo + inside;
+            step = high ? -0.0005 : 0.0005;
+        }
+        const int refStrip = SiStripList::stripId(x0);
+        if ( refStrip == 65535 )
+            continue;
+        x.resize(nClusters);
+        z.resize(nClusters);
+        q.resize(nClusters);
+        for ( int i=0; i<nClusters; ++i ) {
+            x[i] = x0 + i*step;
+            z[i] = -0.2 + 0.4*clusterEngine.flat();
+            q[i] = 100 + 50*clusterEngine.flat();
+        }
+
+        for ( int path=0; path<2; ++path ) {
+            propagateEngine.setSeed(m_seed + 2*block + path, 0);
+            TkrDigiVariates::global().reset();
+            propagate(path==0, nClusters, &x[0], &z[0], &q[0], refStrip,
+                      profile);
+            // the hit lists of the block are gone, don't keep their memory
+            TkrDigiArena::reset();
+            for ( int bin=0; bin<=nBins; ++bin ) {
+                sum[path][bin]  += profile[bin];
+                sum2[path][bin] += profile[bin]*profile[bin];
+            }
+        }
+    }
+
+    CLHEP::HepRandom::setTheEngine(saved);
+    TkrDigiVariates::global().reset();
+
+    double worst = 0.0;
+    int worstBin = 0;
+    for ( int bin=0; bin<=nBins; ++bin ) {
+        double var = 0.0;
+        for ( int path=0; path<2; ++path )
+            var += sum2[path][bin] - sum[path][bin]*sum[path][bin]/m_nBlocks;
+        if ( var <= 0.0 )
+            continue;
+        const double pull = (sum[1][bin]-sum[0][bin]) / std::sqrt(var);
+        if ( std::fabs(pull) > std::fabs(worst) ) {
+            worst    = pull;
+            worstBin = bin;
+        }
+    }
+    log << MSG::INFO << "total current: scalar " << sum[0][nBins]
+        << ", blocks " << sum[1][nBins] << "; largest pull " << worst
+        << " at " << ( worstBin==nBins ? "the total" : "a strip" )
+        << " over " << m_nBlocks << " blocks" << endreq;
+    log << MSG::INFO << ClusterPropagator::resampled() << " of "
+        << ClusterPropagator::carriers() << " carriers resampled, "
+        << ClusterPropagator::fallbacks() << " left undiffused" << endreq;
+    if ( std::fabs(worst) > m_maxPull ) {
+        log << MSG::ERROR << "the block kernel disagrees with the scalar "
+            << "propagation" << endreq;
+        return StatusCode::FAILURE;
+    }
+    return StatusCode::SUCCESS;
+}
+
+//------------------------------------------------------------------------
+void test_BariPropagator::propagate(const bool scalar, const int nClusters,
+                                    const double* x, const double* z,
+                                    const double* q, const int refStrip,
+                                    std::vector<double>& profile)
+{
+    const idents::VolumeIdentifier volId =
+        TkrPlaneKey::fromLayer(0, 0, 0).volumeId();
+    CurrOr mapCurr;
+    if ( scalar )
+        scalarPropagate(&m_openCurr, &mapCurr, x, z, q, nClusters, volId);
+    else {
+        ClusterPropagator propagator;
+        propagator.setMapCurr(&mapCurr);
+        propagator.setOpenCurr(&m_openCurr);
+        propagator.setClusterPropagator(x, z, q, nClusters, volId, 0);
+    }
+
+    profile.assign(2*nSide+2, 0.0);
+    for ( unsigned int i=0; i<mapCurr.size(); ++i ) {
+        const DigiElem& elem = mapCurr.getList()[i];
+        int offset = elem.getStrip() - refStrip;
+        if ( offset < -nSide )
+            offset = -nSide;
+        if ( offset > nSide )
+            offset = nSide;
+        profile[offset+nSide] += elem.getCurrent()[0];
+        profile[2*nSide+1]    += elem.getCurrent()[0];
+    }
+}
+
+//------------------------------------------------------------------------
+//! process an event
+StatusCode test_BariPropagator::execute()
+{
+    return StatusCode::SUCCESS;
+}
+
+//------------------------------------------------------------------------
+//! clean up, summarize
+StatusCode test_BariPropagator::finalize(){
+    return StatusCode::SUCCESS;
+}